@@ -0,0 +1,58 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+Arguments::Arguments(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string name = argv[i];
+    if (!name.starts_with("--")) {
+      continue;
+    }
+    name = name.substr(2);
+    if (i + 1 < argc && !std::string(argv[i + 1]).starts_with("--")) {
+      values[name] = argv[++i];
+    } else {
+      values[name] = "";
+    }
+  }
+}
+
+bool Arguments::flag(const std::string &name) const {
+  return values.contains(name);
+}
+
+size_t Arguments::get(const std::string &name, size_t fallback) const {
+  auto value = values.find(name);
+  return value == values.end() || value->second.empty() ? fallback : std::stoul(value->second);
+}
+
+std::string Arguments::get(const std::string &name, const std::string &fallback) const {
+  auto value = values.find(name);
+  return value == values.end() || value->second.empty() ? fallback : value->second;
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+  auto index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+Summary summarize(std::vector<double> samples) {
+  if (samples.empty()) {
+    return {};
+  }
+  std::ranges::sort(samples);
+  return {
+      .mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size(),
+      .min = samples.front(),
+      .max = samples.back(),
+      .p50 = percentile(samples, 0.50),
+      .p95 = percentile(samples, 0.95),
+      .p99 = percentile(samples, 0.99),
+  };
+}
+
+std::ostream &operator<<(std::ostream &out, const Summary &summary) {
+  return out << "{\"mean\": " << summary.mean << ", \"min\": " << summary.min << ", \"max\": " << summary.max
+             << ", \"p50\": " << summary.p50 << ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99 << "}";
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Parses "--name value" pairs and bare "--flag" switches.
+class Arguments {
+  std::map<std::string, std::string> values;
+
+public:
+  Arguments(int argc, char **argv);
+
+  [[nodiscard]] bool flag(const std::string &name) const;
+  [[nodiscard]] size_t get(const std::string &name, size_t fallback) const;
+  [[nodiscard]] std::string get(const std::string &name, const std::string &fallback) const;
+};
+
+struct Summary {
+  double mean;
+  double min;
+  double max;
+  double p50;
+  double p95;
+  double p99;
+};
+
+Summary summarize(std::vector<double> samples);
+
+// writes "{"mean": ..., ...}"
+std::ostream &operator<<(std::ostream &, const Summary &);
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <frustum.hpp>
+#include <scene.hpp>
+#include <stopwatch.hpp>
+
+#include "bench.hpp"
+
+// unit spheres scattered with random rotation and uneven scale through a cube of the given half size around the origin
+Scene scatteredScene(size_t objectCount, float spread, uint32_t seed) {
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<float> position(-spread, spread);
+  std::uniform_real_distribution<float> scale(0.25f, 2.0f);
+  std::uniform_real_distribution<float> angle(0.0f, glm::radians(360.0f));
+  std::uniform_real_distribution<float> axis(-1.0f, 1.0f);
+
+  Scene scene;
+  for (size_t i = 0; i < objectCount; i++) {
+    auto transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+    transform = glm::rotate(transform, angle(random), glm::normalize(glm::vec3(axis(random), axis(random), 1.0f)));
+    transform = glm::scale(transform, glm::vec3(scale(random), scale(random), scale(random)));
+    scene.add(transform, glm::vec4(1.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  }
+  return scene;
+}
+
+// usage: bench_cull [--objects N] [--iterations N] [--spread N] [--volume sphere|box] [--kernel scalar|sse|avx2]
+// frustum culls a scene of N objects on a single thread with every kernel the cpu supports, or only the given one, and
+// prints the time per cull in milliseconds and millions of objects culled per second per core as json. The camera
+// sits at the origin looking down -z, --spread is the half size of the cube objects are scattered through. Exits with
+// an error when two kernels disagree on what is visible.
+int main(int argc, char **argv) {
+  Arguments arguments(argc, argv);
+  auto objectCount = arguments.get("objects", 1000000);
+  auto iterations = arguments.get("iterations", 100);
+  auto spread = static_cast<float>(arguments.get("spread", 100));
+  auto volumeName = arguments.get("volume", "sphere");
+  if (volumeName != "sphere" && volumeName != "box") {
+    throw std::runtime_error("Unknown cull volume");
+  }
+  auto volume = volumeName == "sphere" ? CullVolume::eSphere : CullVolume::eBox;
+
+  std::vector<CullKernel> kernels;
+  auto kernelName = arguments.get("kernel", "");
+  if (kernelName.empty()) {
+    for (auto kernel : {CullKernel::eScalar, CullKernel::eSse, CullKernel::eAvx2}) {
+      if (supportsCullKernel(kernel)) {
+        kernels.push_back(kernel);
+      }
+    }
+  } else {
+    auto kernel = parseCullKernel(kernelName);
+    if (!kernel || !supportsCullKernel(*kernel)) {
+      throw std::runtime_error("Unknown or unsupported culling kernel");
+    }
+    kernels.push_back(*kernel);
+  }
+
+  auto scene = scatteredScene(objectCount, spread, 1);
+  auto proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, spread);
+  auto frustum = frustumPlanes(proj);
+
+  std::vector<uint32_t> reference;
+  std::cout << "{\n"
+            << "  \"config\": {\"objects\": " << objectCount << ", \"iterations\": " << iterations
+            << ", \"spread\": " << spread << ", \"volume\": \"" << volumeName << "\"},\n"
+            << "  \"kernels\": {";
+  for (size_t k = 0; k < kernels.size(); k++) {
+    std::vector<uint32_t> visible;
+    // the first cull sizes the output and pulls the bounds into cache
+    scene.cull(frustum, visible, volume, kernels[k]);
+    if (k == 0) {
+      reference = visible;
+    } else if (visible != reference) {
+      throw std::runtime_error(std::string("Kernel ") + cullKernelName(kernels[k]) + " disagrees with " +
+                               cullKernelName(kernels[0]));
+    }
+
+    std::vector<double> samples;
+    Stopwatch stopwatch;
+    for (size_t i = 0; i < iterations; i++) {
+      scene.cull(frustum, visible, volume, kernels[k]);
+      samples.push_back(stopwatch.lap());
+    }
+    auto summary = summarize(samples);
+    std::cout << (k == 0 ? "\n" : ",\n") << "    \"" << cullKernelName(kernels[k]) << "\": {\"milliseconds\": "
+              << summary << ", \"mobjects_per_second\": " << objectCount / summary.mean / 1000.0 << "}";
+  }
+  std::cout << "\n  },\n"
+            << "  \"visible\": " << reference.size() << "\n"
+            << "}\n";
+}
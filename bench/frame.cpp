@@ -0,0 +1,161 @@
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include <graphics.hpp>
+#include <stopwatch.hpp>
+#include <trace.hpp>
+
+#include "bench.hpp"
+
+// usage: bench [--headless] [--warmup N] [--frames N] [--objects N] [--mesh FILE] [--vertex-format float|half|snorm]
+//              [--optimize] [--instanced] [--push-constants] [--gpu-culling] [--no-cpu-culling] [--threads N]
+//              [--frames-in-flight N] [--width N] [--height N] [--resize-every N] [--recreate-idle]
+//              [--present-mode fifo|fifo-relaxed|mailbox|immediate] [--swapchain-images N] [--max-latency N]
+//              [--pipeline-cache FILE] [--trace FILE]
+// prints cpu frame time statistics in milliseconds as json, run with and without --instanced to compare one draw
+// per object against a single instanced draw, or with --push-constants to compare a ubo and descriptor bind per
+// object against push constants, sweep --threads to see how recording scales with core count, or
+// --vertex-format to see what smaller vertices save in upload size and gpu time. --optimize reorders the mesh for the
+// vertex cache before upload. --gpu-culling culls and draws on the gpu, its record time should stay flat as --objects
+// grows. --resize-every alternates the window between full and half size every N frames, a resize storm whose
+// swapchain recreation shows up in the events time, where the resize callback runs, --recreate-idle waits for the
+// device to go idle on every recreation instead of retiring the old swapchain. The present options trade
+// throughput for latency, compare present_latency, the cpu submit to present time, across them. Without present wait
+// it is the submit to gpu complete time instead, present_latency_source tells which
+int main(int argc, char **argv) {
+  Arguments arguments(argc, argv);
+  bool headless = arguments.flag("headless");
+  auto warmupFrames = arguments.get("warmup", 100);
+  auto measuredFrames = arguments.get("frames", 1000);
+  auto resizeEvery = arguments.get("resize-every", 0);
+  if (arguments.flag("trace") && !TRACING_ENABLED) {
+    throw std::runtime_error("--trace needs a build configured with -DENABLE_TRACING=ON");
+  }
+  auto extent = vk::Extent2D{
+      static_cast<uint32_t>(arguments.get("width", 1920)),
+      static_cast<uint32_t>(arguments.get("height", 1080)),
+  };
+  auto vertexFormat = parseVertexFormat(arguments.get("vertex-format", "float"));
+  if (!vertexFormat) {
+    throw std::runtime_error("Unknown vertex format");
+  }
+  if (arguments.get("objects", 1) == 0) {
+    throw std::runtime_error("--objects has to be at least 1");
+  }
+  auto presentMode = parsePresentMode(arguments.get("present-mode", "mailbox"));
+  if (!presentMode) {
+    throw std::runtime_error("Unknown present mode");
+  }
+  Settings settings{
+      .objectCount = static_cast<uint32_t>(arguments.get("objects", 1)),
+      .meshPath = arguments.get("mesh", ""),
+      .vertexFormat = *vertexFormat,
+      .optimizeMesh = arguments.flag("optimize"),
+      .instanced = arguments.flag("instanced"),
+      .pushConstants = arguments.flag("push-constants"),
+      .gpuCulling = arguments.flag("gpu-culling"),
+      .cpuCulling = !arguments.flag("no-cpu-culling"),
+      .recordThreads = static_cast<uint32_t>(arguments.get("threads", 1)),
+      .framesInFlight = static_cast<uint32_t>(arguments.get("frames-in-flight", DEFAULT_FRAMES_IN_FLIGHT)),
+      .present =
+          {
+              .mode = *presentMode,
+              .imageCount = static_cast<uint32_t>(arguments.get("swapchain-images", 0)),
+              .maxFrameLatency = static_cast<uint32_t>(arguments.get("max-latency", 0)),
+          },
+      .recreateIdle = arguments.flag("recreate-idle"),
+      .pipelineCachePath = arguments.get("pipeline-cache", ""),
+  };
+
+  std::optional<vkfw::UniqueHandle<vkfw::Instance>> instance;
+  std::optional<vkfw::UniqueHandle<vkfw::Window>> window;
+  std::optional<Graphics> graphics;
+  if (headless) {
+    graphics.emplace(extent, settings);
+  } else {
+    instance = vkfw::initUnique();
+    window = vkfw::createWindowUnique(extent.width, extent.height, "vulkan tutorial bench");
+    graphics.emplace(**window, settings);
+    // recreates the swapchain inside pollEvents, so the events time holds the cost of a resize
+    (*window)->callbacks()->on_framebuffer_resize = [&](const vkfw::Window &, size_t width, size_t height) {
+      graphics->resize({static_cast<uint32_t>(width), static_cast<uint32_t>(height)});
+    };
+  }
+
+  std::vector<double> total, events, gpuWait, latencyWait, acquire, record, submit, present;
+  for (size_t i = 0; i < warmupFrames + measuredFrames; i++) {
+    double eventMilliseconds = 0.0;
+    if (window) {
+      if (resizeEvery > 0 && i % resizeEvery == 0) {
+        auto divisor = i / resizeEvery % 2 + 1;
+        (*window)->setSize(extent.width / divisor, extent.height / divisor);
+      }
+      Stopwatch stopwatch;
+      vkfw::pollEvents();
+      eventMilliseconds = stopwatch.lap();
+      graphics->draw(**window);
+    } else {
+      graphics->draw();
+    }
+    if (i < warmupFrames) {
+      continue;
+    }
+    const auto &timings = graphics->lastFrameTimings();
+    events.push_back(eventMilliseconds);
+    total.push_back(timings.total);
+    gpuWait.push_back(timings.gpuWait);
+    latencyWait.push_back(timings.latencyWait);
+    acquire.push_back(timings.acquire);
+    record.push_back(timings.record);
+    submit.push_back(timings.submit);
+    present.push_back(timings.present);
+  }
+
+  // only the last PresentMonitor::HISTORY_LENGTH frames are kept, empty headless
+  const auto &latencies = graphics->presentLatency().history();
+  std::cout << "{\n"
+            << "  \"config\": {\"headless\": " << (headless ? "true" : "false") << ", \"warmup\": " << warmupFrames
+            << ", \"frames\": " << measuredFrames << ", \"objects\": " << settings.objectCount
+            << ", \"vertex_format\": \"" << vertexFormatInfo(settings.vertexFormat).name
+            << "\", \"vertex_bytes\": " << graphics->mesh().vertexBuffer.size
+            << ", \"optimize\": " << (settings.optimizeMesh ? "true" : "false")
+            << ", \"instanced\": " << (settings.instanced ? "true" : "false")
+            << ", \"push_constants\": " << (settings.pushConstants ? "true" : "false")
+            << ", \"gpu_culling\": " << (settings.gpuCulling ? "true" : "false")
+            << ", \"cpu_culling\": " << (settings.cpuCulling ? "true" : "false")
+            << ", \"threads\": " << settings.recordThreads << ", \"frames_in_flight\": " << settings.framesInFlight
+            << ", \"width\": " << extent.width << ", \"height\": " << extent.height
+            << ", \"resize_every\": " << resizeEvery
+            << ", \"recreate_idle\": " << (settings.recreateIdle ? "true" : "false") << ", \"present_mode\": \""
+            << presentModeName(settings.present.mode) << "\", \"swapchain_images\": " << settings.present.imageCount
+            << ", \"max_latency\": " << settings.present.maxFrameLatency << "},\n"
+            << "  \"frame\": " << summarize(total) << ",\n"
+            << "  \"events\": " << summarize(events) << ",\n"
+            << "  \"gpu_wait\": " << summarize(gpuWait) << ",\n"
+            << "  \"latency_wait\": " << summarize(latencyWait) << ",\n"
+            << "  \"acquire\": " << summarize(acquire) << ",\n"
+            << "  \"record\": " << summarize(record) << ",\n"
+            << "  \"submit\": " << summarize(submit) << ",\n"
+            << "  \"present\": " << summarize(present) << ",\n"
+            << "  \"present_latency_source\": \""
+            << (graphics->presentLatency().usesPresentWait() ? "submit_to_present" : "submit_to_gpu_complete")
+            << "\",\n"
+            << "  \"present_latency\": " << summarize({latencies.begin(), latencies.end()}) << ",\n"
+            << "  \"gpu\": {";
+  // only the last GpuProfiler::HISTORY_LENGTH frames are kept
+  const auto &history = graphics->gpuProfiler().history();
+  for (auto scope = history.begin(); scope != history.end(); scope++) {
+    std::cout << (scope == history.begin() ? "" : ", ") << "\"" << scope->first
+              << "\": " << summarize({scope->second.begin(), scope->second.end()});
+  }
+  std::cout << "}\n"
+            << "}\n";
+
+  if (arguments.flag("trace")) {
+    std::ofstream trace(arguments.get("trace", "trace.json"));
+    dumpTrace(trace);
+  }
+}
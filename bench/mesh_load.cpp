@@ -0,0 +1,100 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <base.hpp>
+#include <device.hpp>
+#include <drawable.hpp>
+#include <mesh_file.hpp>
+#include <stopwatch.hpp>
+#include <uploader.hpp>
+
+#include "bench.hpp"
+
+// side x side quads sharing their corners
+void writeGrid(const std::filesystem::path &path, size_t side) {
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+  for (size_t y = 0; y <= side; y++) {
+    for (size_t x = 0; x <= side; x++) {
+      auto u = static_cast<float>(x) / side;
+      auto v = static_cast<float>(y) / side;
+      vertices.push_back({{u * 2.0f - 1.0f, v * 2.0f - 1.0f}, {u, v, 1.0f}});
+    }
+  }
+  for (size_t y = 0; y < side; y++) {
+    for (size_t x = 0; x < side; x++) {
+      auto corner = static_cast<uint32_t>(y * (side + 1) + x);
+      auto above = corner + static_cast<uint32_t>(side + 1);
+      indices.insert(indices.end(), {corner, corner + 1, above + 1, above + 1, above, corner});
+    }
+  }
+  std::ofstream out(path, std::ios::binary);
+  writeMeshFile(out, vertices, indices);
+}
+
+// usage: bench_mesh_load [--mesh FILE] [--grid N] [--iterations N] [--vertex-format float|half|snorm]
+// maps a mesh file and copies it through staging memory into device local buffers, prints the time of each step in
+// milliseconds and the throughput in MB/s as json. Without --mesh a grid of N x N quads is written to the temp
+// directory first and removed afterwards. Iterations after the first read from the os page cache. Float files uploaded
+// in a packed format are quantized while staging.
+int main(int argc, char **argv) {
+  Arguments arguments(argc, argv);
+  auto iterations = arguments.get("iterations", 20);
+  std::filesystem::path meshPath = arguments.get("mesh", "");
+  std::filesystem::path gridPath;
+  if (meshPath.empty()) {
+    gridPath = std::filesystem::temp_directory_path() / "bench_grid.mesh";
+    writeGrid(gridPath, arguments.get("grid", 512));
+    meshPath = gridPath;
+  }
+
+  auto vertexFormat = parseVertexFormat(arguments.get("vertex-format", "float"));
+  if (!vertexFormat) {
+    throw std::runtime_error("Unknown vertex format");
+  }
+
+  Base base(nullptr);
+  Device device(base.instance, base.surface);
+  Uploader uploader(device.handle,
+                    device.allocator,
+                    device.transferQueue,
+                    device.details.transferQueueFamilyIndex,
+                    device.queue,
+                    device.details.queueFamilyIndex);
+
+  size_t fileSize = 0;
+  size_t vertexBytes = 0;
+  std::vector<double> map, stage, upload, total, throughput;
+  for (size_t i = 0; i < iterations; i++) {
+    Stopwatch stopwatch;
+    MeshFile mesh(meshPath);
+    map.push_back(stopwatch.lap());
+    DrawableBuffers buffers(device.handle, device.allocator, uploader, mesh, *vertexFormat);
+    stage.push_back(stopwatch.lap());
+    uploader.wait(buffers.ticket);
+    upload.push_back(stopwatch.lap());
+
+    fileSize = mesh.size();
+    vertexBytes = buffers.vertexBuffer.size;
+    total.push_back(map.back() + stage.back() + upload.back());
+    // bytes per millisecond to megabytes per second
+    throughput.push_back(fileSize / total.back() / 1000.0);
+  }
+  if (!gridPath.empty()) {
+    std::filesystem::remove(gridPath);
+  }
+
+  std::cout << "{\n"
+            << "  \"config\": {\"mesh\": " << meshPath << ", \"bytes\": " << fileSize
+            << ", \"vertex_format\": \"" << vertexFormatInfo(*vertexFormat).name
+            << "\", \"vertex_bytes\": " << vertexBytes << ", \"iterations\": " << iterations << "},\n"
+            << "  \"map\": " << summarize(map) << ",\n"
+            << "  \"stage\": " << summarize(stage) << ",\n"
+            << "  \"upload\": " << summarize(upload) << ",\n"
+            << "  \"total\": " << summarize(total) << ",\n"
+            << "  \"mb_per_s\": " << summarize(throughput) << "\n"
+            << "}\n";
+}
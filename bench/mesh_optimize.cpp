@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mesh_file.hpp>
+#include <mesh_optimizer.hpp>
+#include <stopwatch.hpp>
+#include <thread_pool.hpp>
+
+#include "bench.hpp"
+
+// side x side quads as a shuffled triangle soup, every corner its own vertex, the worst case an exporter produces
+MeshData shuffledGrid(size_t side, uint32_t seed) {
+  MeshData mesh;
+  auto corner = [&](size_t x, size_t y) {
+    auto u = static_cast<float>(x) / side;
+    auto v = static_cast<float>(y) / side;
+    return Vertex{{u * 2.0f - 1.0f, v * 2.0f - 1.0f}, {u, v, 1.0f}};
+  };
+  for (size_t y = 0; y < side; y++) {
+    for (size_t x = 0; x < side; x++) {
+      mesh.vertices.insert(mesh.vertices.end(),
+                           {corner(x, y), corner(x + 1, y), corner(x + 1, y + 1),
+                            corner(x + 1, y + 1), corner(x, y + 1), corner(x, y)});
+    }
+  }
+
+  std::vector<uint32_t> triangles(mesh.vertices.size() / 3);
+  for (uint32_t i = 0; i < triangles.size(); i++) {
+    triangles[i] = i;
+  }
+  std::ranges::shuffle(triangles, std::mt19937(seed));
+  for (auto triangle : triangles) {
+    mesh.indices.insert(mesh.indices.end(), {triangle * 3, triangle * 3 + 1, triangle * 3 + 2});
+  }
+  return mesh;
+}
+
+// usage: bench_mesh_optimize [--mesh FILE] [--grid N] [--meshes N] [--threads N] [--cache N]
+// optimizes a batch of meshes on a thread pool and prints the wall time in milliseconds plus the ACMR and ATVR of
+// every mesh before and after as json. Without --mesh each mesh is a shuffled triangle soup of an N x N quad grid,
+// with it the file is optimized --meshes times.
+int main(int argc, char **argv) {
+  Arguments arguments(argc, argv);
+  auto meshCount = arguments.get("meshes", 16);
+  auto threads = arguments.get("threads", std::max(std::thread::hardware_concurrency(), 1u));
+  MeshOptimizerSettings settings{
+      .cacheSize = static_cast<uint32_t>(arguments.get("cache", 16)),
+  };
+
+  std::vector<MeshData> meshes;
+  std::string meshPath = arguments.get("mesh", "");
+  for (size_t i = 0; i < meshCount; i++) {
+    meshes.push_back(meshPath.empty() ? shuffledGrid(arguments.get("grid", 128), static_cast<uint32_t>(i))
+                                      : readMeshData(MeshFile(meshPath)));
+  }
+
+  ThreadPool workers(threads);
+  Stopwatch stopwatch;
+  auto reports = optimizeMeshes(meshes, workers, settings);
+  auto milliseconds = stopwatch.lap();
+
+  size_t verticesBefore = 0, verticesAfter = 0;
+  std::vector<double> acmrBefore, acmrAfter, atvrBefore, atvrAfter;
+  for (const auto &report : reports) {
+    verticesBefore += report.verticesBefore;
+    verticesAfter += report.verticesAfter;
+    acmrBefore.push_back(report.before.acmr);
+    acmrAfter.push_back(report.after.acmr);
+    atvrBefore.push_back(report.before.atvr);
+    atvrAfter.push_back(report.after.atvr);
+  }
+
+  std::cout << "{\n"
+            << "  \"config\": {\"mesh\": \"" << meshPath << "\", \"meshes\": " << meshCount
+            << ", \"threads\": " << threads << ", \"cache\": " << settings.cacheSize << "},\n"
+            << "  \"milliseconds\": " << milliseconds << ",\n"
+            << "  \"vertices\": {\"before\": " << verticesBefore << ", \"after\": " << verticesAfter << "},\n"
+            << "  \"acmr\": {\"before\": " << summarize(acmrBefore) << ", \"after\": " << summarize(acmrAfter) << "},\n"
+            << "  \"atvr\": {\"before\": " << summarize(atvrBefore) << ", \"after\": " << summarize(atvrAfter) << "}\n"
+            << "}\n";
+}
@@ -0,0 +1,59 @@
+#include <filesystem>
+#include <iostream>
+#include <optional>
+
+#include <graphics.hpp>
+
+#include "bench.hpp"
+
+void printStartup(std::ostream &out, const StartupTimings &startup) {
+  out << "{\"warm_pipeline_cache\": " << (startup.warmPipelineCache ? "true" : "false")
+      << ", \"total\": " << startup.total << ", \"phases\": {";
+  for (auto phase = startup.phases.begin(); phase != startup.phases.end(); phase++) {
+    out << (phase == startup.phases.begin() ? "" : ", ") << "\"" << phase->first << "\": " << phase->second;
+  }
+  out << "}, \"first_frame\": " << startup.firstFrame << ", \"pipelines\": {";
+  for (auto pipeline = startup.pipelines.begin(); pipeline != startup.pipelines.end(); pipeline++) {
+    out << (pipeline == startup.pipelines.begin() ? "" : ", ") << "\"" << pipeline->name << "\": {\"start\": "
+        << pipeline->start << ", \"end\": " << pipeline->end << "}";
+  }
+  out << "}}";
+}
+
+// usage: bench_startup [--cache FILE] [--width N] [--height N]
+// the cache defaults to a file in the temporary directory
+// constructs a headless renderer twice, first after deleting the pipeline cache and then with the cache the first
+// run saved on shutdown, and prints both startups in milliseconds as json. Each run submits one frame and then waits
+// for the background pipeline compiles, so their overlap with the first frame shows up.
+int main(int argc, char **argv) {
+  Arguments arguments(argc, argv);
+  std::filesystem::path cachePath =
+      arguments.get("cache", (std::filesystem::temp_directory_path() / "bench_pipeline_cache.bin").string());
+  auto extent = vk::Extent2D{
+      static_cast<uint32_t>(arguments.get("width", 1920)),
+      static_cast<uint32_t>(arguments.get("height", 1080)),
+  };
+  Settings settings{.pipelineCachePath = cachePath};
+
+  std::filesystem::remove(cachePath);
+  std::optional<Graphics> graphics;
+  graphics.emplace(extent, settings);
+  graphics->draw();
+  graphics->waitForPipelines();
+  auto cold = graphics->startupTimings();
+  // destroying the renderer saves the cache
+  graphics.reset();
+  graphics.emplace(extent, settings);
+  graphics->draw();
+  graphics->waitForPipelines();
+  auto warm = graphics->startupTimings();
+
+  std::cout << "{\n"
+            << "  \"cold\": ";
+  printStartup(std::cout, cold);
+  std::cout << ",\n"
+            << "  \"warm\": ";
+  printStartup(std::cout, warm);
+  std::cout << "\n"
+            << "}\n";
+}
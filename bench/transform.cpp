@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <scene.hpp>
+#include <stopwatch.hpp>
+#include <thread_pool.hpp>
+
+#include "bench.hpp"
+
+glm::mat4 spin(size_t iteration) {
+  return glm::rotate(glm::mat4(1.0f), glm::radians(static_cast<float>(iteration)), glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+// usage: bench_transform [--objects N] [--iterations N] [--threads N] [--dirty PERCENT] [--stride N]
+// updates the world matrices and bounds of a scene, then writes the model view projection matrix of every object
+// --stride bytes apart into a buffer laid out like the per-object ubo slots. Prints milliseconds per step and millions
+// of matrices per second as json. --dirty is the share of objects whose transform changes every iteration, 100
+// changes the shared model matrix instead so every object is recomputed. A single threaded loop of plain glm math
+// doing the same work for every object is timed as the baseline.
+int main(int argc, char **argv) {
+  Arguments arguments(argc, argv);
+  auto objectCount = arguments.get("objects", 100000);
+  auto iterations = arguments.get("iterations", 100);
+  auto threads = arguments.get("threads", std::max(std::thread::hardware_concurrency(), 1u));
+  auto dirtyPercent = std::min<size_t>(arguments.get("dirty", 100), 100);
+  auto stride = std::max<size_t>(arguments.get("stride", 256), sizeof(glm::mat4));
+
+  Scene scene;
+  std::vector<glm::mat4> locals;
+  for (size_t i = 0; i < objectCount; i++) {
+    locals.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(i % 100, i / 100 % 100, i / 10000)));
+    scene.add(locals.back(), glm::vec4(1.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  }
+  std::vector<uint32_t> objects(objectCount);
+  std::iota(objects.begin(), objects.end(), 0);
+  std::vector<std::byte> destination(objectCount * stride);
+
+  auto view = glm::lookAt(glm::vec3(50.0f, 50.0f, 150.0f), glm::vec3(50.0f, 50.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  auto clipFromWorld = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f) * view;
+  auto dirtyCount = objectCount * dirtyPercent / 100;
+
+  ThreadPool workers(threads > 1 ? threads : 0);
+  scene.update(workers);
+  std::vector<double> updateSamples, writeSamples, baselineSamples;
+  size_t updated = 0;
+  for (size_t iteration = 0; iteration < iterations; iteration++) {
+    if (dirtyPercent == 100) {
+      scene.setModel(spin(iteration));
+    } else {
+      // a moving window, so consecutive iterations dirty different objects
+      for (size_t i = 0; i < dirtyCount; i++) {
+        auto index = static_cast<uint32_t>((iteration * dirtyCount + i) % objectCount);
+        scene.setTransform(index, locals[index]);
+      }
+    }
+    Stopwatch stopwatch;
+    updated += scene.update(workers);
+    updateSamples.push_back(stopwatch.lap());
+    scene.writeMvps(objects, clipFromWorld, destination.data(), stride, workers);
+    writeSamples.push_back(stopwatch.lap());
+
+    auto model = spin(iteration);
+    for (size_t i = 0; i < objectCount; i++) {
+      auto mvp = clipFromWorld * (locals[i] * model);
+      std::memcpy(destination.data() + i * stride, &mvp, sizeof(mvp));
+    }
+    baselineSamples.push_back(stopwatch.lap());
+  }
+
+  auto update = summarize(updateSamples);
+  auto write = summarize(writeSamples);
+  auto baseline = summarize(baselineSamples);
+  auto updatedPerIteration = static_cast<double>(updated) / std::max<size_t>(iterations, 1);
+  std::cout << "{\n"
+            << "  \"config\": {\"objects\": " << objectCount << ", \"iterations\": " << iterations
+            << ", \"threads\": " << threads << ", \"dirty\": " << dirtyPercent << ", \"stride\": " << stride << "},\n"
+            << "  \"update\": {\"milliseconds\": " << update << ", \"updated\": " << updatedPerIteration
+            << ", \"mmatrices_per_second\": " << updatedPerIteration / update.mean / 1000.0 << "},\n"
+            << "  \"write_mvp\": {\"milliseconds\": " << write
+            << ", \"mmatrices_per_second\": " << objectCount / write.mean / 1000.0 << "},\n"
+            << "  \"scalar_baseline\": {\"milliseconds\": " << baseline
+            << ", \"mmatrices_per_second\": " << objectCount / baseline.mean / 1000.0 << "}\n"
+            << "}\n";
+}
@@ -1,23 +1,148 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+
 #include <graphics.hpp>
+#include <spsc_queue.hpp>
+#include <trace.hpp>
+#include <triple_buffer.hpp>
+
+// the main thread advances the simulation in steps of this length and handles events in between, the render thread
+// draws the latest snapshot
+constexpr double SIMULATION_STEP_SECONDS = 1.0 / 240.0;
+
+// the app opts into a pipeline cache in the working directory, benches keep theirs in memory unless asked
+Settings appSettings() {
+  return {.pipelineCachePath = "pipeline_cache.bin"};
+}
+
+struct ResizeMessage {
+  vk::Extent2D framebufferSize;
+};
 
 struct App {
   const vkfw::UniqueHandle<vkfw::Instance> vkfw = vkfw::initUnique();
   const vkfw::UniqueHandle<vkfw::Window> window =
       vkfw::createWindowUnique(1920, 1080, "vulkan tutorial", {.resizable = true});
 
+  // created on the main thread, only the render thread touches it until that is joined
   Graphics graphics;
+  TripleBuffer<FrameSnapshot> snapshots{animate(0.0)};
+  SpscQueue<ResizeMessage, 64> messages;
+  std::atomic<bool> rendering = true;
+  // the framebuffer is zero sized, the render thread stops drawing until a size arrives again
+  std::atomic<bool> minimized = false;
+  std::exception_ptr renderError;
 
-  App() : graphics(*window) {}
+  App() : graphics(*window, appSettings()) {
+    window->callbacks()->on_framebuffer_resize = [&](const vkfw::Window &, size_t width, size_t height) {
+      // no swapchain can have a zero sized extent, the last valid size stays until the window is restored
+      minimized = width == 0 || height == 0;
+      if (!minimized) {
+        send(ResizeMessage{{static_cast<uint32_t>(width), static_cast<uint32_t>(height)}});
+      }
+    };
+  }
+
+  void send(const ResizeMessage &message) {
+    while (!messages.push(message) && rendering) {
+      std::this_thread::yield();
+    }
+  }
+
+  void render(std::stop_token stop) {
+    try {
+      while (!stop.stop_requested()) {
+        // a resize storm queues many sizes, only the last one gets a swapchain
+        std::optional<vk::Extent2D> framebufferSize;
+        while (auto message = messages.pop()) {
+          framebufferSize = message->framebufferSize;
+        }
+        if (framebufferSize) {
+          graphics.resize(*framebufferSize);
+        }
+        if (minimized) {
+          std::this_thread::sleep_for(std::chrono::duration<double>(SIMULATION_STEP_SECONDS));
+          continue;
+        }
+        graphics.draw(snapshots.read());
+      }
+    } catch (...) {
+      renderError = std::current_exception();
+      rendering = false;
+    }
+  }
 
   void main() {
-    while (!window->shouldClose()) {
-      vkfw::pollEvents();
-      graphics.draw(*window);
+    // stopped and joined on the way out, also when event handling throws
+    std::jthread renderThread([this](std::stop_token stop) { render(stop); });
+    auto start = std::chrono::steady_clock::now();
+    uint64_t steps = 0;
+    while (!window->shouldClose() && rendering) {
+      auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      // whole steps only, several at once after a stall, so the simulated time never depends on when events arrive
+      if (elapsed >= (steps + 1) * SIMULATION_STEP_SECONDS) {
+        steps = static_cast<uint64_t>(elapsed / SIMULATION_STEP_SECONDS);
+        snapshots.write(animate(steps * SIMULATION_STEP_SECONDS));
+      }
+      // glfw rejects negative timeouts, which rounding could produce right at a step boundary
+      vkfw::waitEventsTimeout(std::max((steps + 1) * SIMULATION_STEP_SECONDS - elapsed, 0.0));
     }
+    renderThread.request_stop();
+    renderThread.join();
+    if (renderError) {
+      std::rethrow_exception(renderError);
+    }
+    graphics.report(std::cout);
   }
 };
 
-int main() {
-  App app;
-  app.main();
+struct HeadlessApp {
+  Graphics graphics{vk::Extent2D{1920, 1080}, appSettings()};
+
+  void main(size_t frameCount) {
+    for (size_t i = 0; i < frameCount; i++) {
+      graphics.draw();
+    }
+    graphics.report(std::cout);
+  }
+};
+
+int main(int argc, char **argv) {
+  // usage: main [--headless <frames>] [--trace <file>]
+  std::optional<size_t> headlessFrames;
+  std::optional<std::string> tracePath;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::string_view(argv[i]) == "--headless") {
+      headlessFrames = std::stoul(argv[i + 1]);
+    } else if (std::string_view(argv[i]) == "--trace") {
+      tracePath = argv[i + 1];
+    }
+  }
+  if (tracePath && !TRACING_ENABLED) {
+    std::cerr << "--trace needs a build configured with -DENABLE_TRACING=ON\n";
+    return 1;
+  }
+
+  if (headlessFrames) {
+    HeadlessApp app;
+    app.main(*headlessFrames);
+  } else {
+    App app;
+    app.main();
+  }
+
+  if (tracePath) {
+    std::ofstream trace(*tracePath);
+    dumpTrace(trace);
+  }
 }
@@ -0,0 +1,237 @@
+#include "allocator.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <optional>
+#include <utility>
+
+#include "trace.hpp"
+
+struct Allocation::Block {
+  uint32_t memoryTypeIndex;
+  vk::DeviceSize size;
+  bool dedicated;
+  vk::raii::DeviceMemory memory;
+  std::byte *mapped;
+  // offset -> size, kept coalesced
+  std::map<vk::DeviceSize, vk::DeviceSize> freeRanges;
+  size_t allocationCount;
+};
+
+std::optional<vk::DeviceSize> takeRange(Allocation::Block &block, vk::DeviceSize size, vk::DeviceSize alignment) {
+  for (auto range = block.freeRanges.begin(); range != block.freeRanges.end(); range++) {
+    auto [rangeOffset, rangeSize] = *range;
+    auto offset = alignUp(rangeOffset, alignment);
+    if (offset + size > rangeOffset + rangeSize) {
+      continue;
+    }
+
+    block.freeRanges.erase(range);
+    if (offset > rangeOffset) {
+      block.freeRanges.emplace(rangeOffset, offset - rangeOffset);
+    }
+    if (offset + size < rangeOffset + rangeSize) {
+      block.freeRanges.emplace(offset + size, rangeOffset + rangeSize - (offset + size));
+    }
+    block.allocationCount++;
+    return offset;
+  }
+  return std::nullopt;
+}
+
+Allocation::Allocation(const Allocator *allocator, Block *block, vk::DeviceSize offset, vk::DeviceSize size)
+    : allocator(allocator),
+      block(block),
+      memory(*block->memory),
+      offset(offset),
+      size(size),
+      mapped(block->mapped ? block->mapped + offset : nullptr) {}
+
+Allocation::Allocation(Allocation &&other) noexcept
+    : allocator(std::exchange(other.allocator, nullptr)),
+      block(std::exchange(other.block, nullptr)),
+      memory(std::exchange(other.memory, nullptr)),
+      offset(other.offset),
+      size(other.size),
+      mapped(std::exchange(other.mapped, nullptr)) {}
+
+Allocation &Allocation::operator=(Allocation &&other) noexcept {
+  if (this != &other) {
+    if (allocator) {
+      allocator->free(block, offset, size);
+    }
+    allocator = std::exchange(other.allocator, nullptr);
+    block = std::exchange(other.block, nullptr);
+    memory = std::exchange(other.memory, nullptr);
+    offset = other.offset;
+    size = other.size;
+    mapped = std::exchange(other.mapped, nullptr);
+  }
+  return *this;
+}
+
+Allocation::~Allocation() {
+  if (allocator) {
+    allocator->free(block, offset, size);
+  }
+}
+
+std::vector<vk::DeviceSize> blockSizes(const vk::PhysicalDeviceMemoryProperties &memoryProperties) {
+  std::vector<vk::DeviceSize> result;
+  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+    auto heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size;
+    result.push_back(std::min(Allocator::DEFAULT_BLOCK_SIZE, heapSize / 8));
+  }
+  return result;
+}
+
+Allocator::Allocator(const vk::raii::Device &device, const vk::raii::PhysicalDevice &physicalDevice)
+    : device(device), memoryProperties(physicalDevice.getMemoryProperties()) {
+  for (auto blockSize : blockSizes(memoryProperties)) {
+    pools.push_back({.blockSize = blockSize});
+  }
+}
+
+Allocator::~Allocator() = default;
+
+uint32_t Allocator::findMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags memoryPropertyFlags) const {
+  std::bitset<32> allowedTypes = memoryTypeBits;
+  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+    auto propertyFlags = memoryProperties.memoryTypes[i].propertyFlags;
+    if (allowedTypes[i] && (propertyFlags & memoryPropertyFlags) == memoryPropertyFlags) {
+      return i;
+    }
+  }
+  throw std::runtime_error("No suitable memory type");
+}
+
+Allocation::Block &Allocator::createBlock(uint32_t memoryTypeIndex, vk::DeviceSize size, bool dedicated) const {
+  TRACE_SCOPE("Allocator::createBlock");
+  auto memory = device.allocateMemory({
+      .allocationSize = size,
+      .memoryTypeIndex = memoryTypeIndex,
+  });
+  std::byte *mapped = nullptr;
+  if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+    mapped = static_cast<std::byte *>(memory.mapMemory(0, VK_WHOLE_SIZE));
+  }
+
+  auto &pool = pools[memoryTypeIndex];
+  pool.blocks.push_back(std::make_unique<Allocation::Block>(Allocation::Block{
+      .memoryTypeIndex = memoryTypeIndex,
+      .size = size,
+      .dedicated = dedicated,
+      .memory = std::move(memory),
+      .mapped = mapped,
+      .freeRanges = {{0, size}},
+      .allocationCount = 0,
+  }));
+  totalBlocks++;
+  return *pool.blocks.back();
+}
+
+Allocation Allocator::allocate(const vk::MemoryRequirements &requirements,
+                               vk::MemoryPropertyFlags memoryPropertyFlags,
+                               bool dedicated) const {
+  auto memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, memoryPropertyFlags);
+
+  std::scoped_lock lock(mutex);
+  auto &pool = pools[memoryTypeIndex];
+  // large requests would mostly waste a shared block, give them their own
+  dedicated = dedicated || requirements.size > pool.blockSize / 2;
+
+  Allocation::Block *block = nullptr;
+  std::optional<vk::DeviceSize> offset;
+  if (!dedicated) {
+    for (auto &candidate : pool.blocks) {
+      if (!candidate->dedicated && (offset = takeRange(*candidate, requirements.size, requirements.alignment))) {
+        block = candidate.get();
+        break;
+      }
+    }
+  }
+  if (!block) {
+    block = &createBlock(memoryTypeIndex, dedicated ? requirements.size : pool.blockSize, dedicated);
+    offset = takeRange(*block, requirements.size, requirements.alignment);
+  }
+
+  allocationCount++;
+  totalAllocations++;
+  return {this, block, *offset, requirements.size};
+}
+
+void Allocator::free(Allocation::Block *block, vk::DeviceSize offset, vk::DeviceSize size) const {
+  std::scoped_lock lock(mutex);
+  allocationCount--;
+  block->allocationCount--;
+
+  auto [range, _] = block->freeRanges.emplace(offset, size);
+  auto next = std::next(range);
+  if (next != block->freeRanges.end() && range->first + range->second == next->first) {
+    range->second += next->second;
+    block->freeRanges.erase(next);
+  }
+  if (range != block->freeRanges.begin()) {
+    auto previous = std::prev(range);
+    if (previous->first + previous->second == range->first) {
+      previous->second += range->second;
+      block->freeRanges.erase(range);
+    }
+  }
+
+  if (block->allocationCount > 0) {
+    return;
+  }
+  // keep a single empty block around per pool so alternating allocations don't thrash vkAllocateMemory
+  auto &blocks = pools[block->memoryTypeIndex].blocks;
+  auto emptyBlocks =
+      std::ranges::count_if(blocks, [](const auto &b) { return !b->dedicated && b->allocationCount == 0; });
+  if (block->dedicated || emptyBlocks > 1) {
+    std::erase_if(blocks, [&](const auto &b) { return b.get() == block; });
+  }
+}
+
+Allocator::Stats Allocator::stats() const {
+  std::scoped_lock lock(mutex);
+  Stats result{
+      .allocationCount = allocationCount,
+      .totalBlocks = totalBlocks,
+      .totalAllocations = totalAllocations,
+  };
+
+  vk::DeviceSize freeBytes = 0;
+  vk::DeviceSize largestFreeRange = 0;
+  for (uint32_t i = 0; i < pools.size(); i++) {
+    auto propertyFlags = memoryProperties.memoryTypes[i].propertyFlags;
+    for (const auto &block : pools[i].blocks) {
+      vk::DeviceSize blockFreeBytes = 0;
+      for (auto [_, size] : block->freeRanges) {
+        blockFreeBytes += size;
+        largestFreeRange = std::max(largestFreeRange, size);
+      }
+      auto usedBytes = block->size - blockFreeBytes;
+
+      result.blockCount++;
+      result.blockBytes += block->size;
+      result.usedBytes += usedBytes;
+      if (propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+        result.hostVisibleBytes += usedBytes;
+      }
+      if (propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal) {
+        result.deviceLocalBytes += usedBytes;
+      }
+      freeBytes += blockFreeBytes;
+    }
+  }
+  result.fragmentation = freeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(largestFreeRange) / freeBytes;
+  return result;
+}
+
+std::ostream &operator<<(std::ostream &out, const Allocator::Stats &stats) {
+  return out << "blocks: " << stats.blockCount << " (" << stats.totalBlocks << " allocated in total)\n"
+             << "allocations: " << stats.allocationCount << " (" << stats.totalAllocations << " served in total)\n"
+             << "block bytes: " << stats.blockBytes << ", used bytes: " << stats.usedBytes << "\n"
+             << "host visible bytes: " << stats.hostVisibleBytes << ", device local bytes: " << stats.deviceLocalBytes
+             << "\n"
+             << "fragmentation: " << stats.fragmentation << "\n";
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+class Allocator;
+
+// rounds value up to a multiple of alignment, which doesn't have to be a power of two
+constexpr vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// A range of device memory handed out by an Allocator, returned to it on destruction.
+struct Allocation {
+  struct Block;
+
+  const Allocator *allocator = nullptr;
+  Block *block = nullptr;
+  vk::DeviceMemory memory;
+  vk::DeviceSize offset = 0;
+  vk::DeviceSize size = 0;
+  // null unless the memory type is host visible, blocks are mapped for their whole lifetime
+  std::byte *mapped = nullptr;
+
+  Allocation() = default;
+  Allocation(const Allocator *, Block *, vk::DeviceSize, vk::DeviceSize);
+  Allocation(Allocation &&) noexcept;
+  Allocation &operator=(Allocation &&) noexcept;
+  ~Allocation();
+};
+
+// Sub-allocates buffers out of large vkAllocateMemory blocks, one pool of blocks per memory type.
+class Allocator {
+public:
+  struct Stats {
+    size_t blockCount;
+    size_t allocationCount;
+    size_t totalBlocks;
+    size_t totalAllocations;
+    vk::DeviceSize blockBytes;
+    vk::DeviceSize usedBytes;
+    vk::DeviceSize hostVisibleBytes;
+    vk::DeviceSize deviceLocalBytes;
+    // 1 - largest free range / total free, 0 when free space is a single range
+    float fragmentation;
+  };
+
+  static constexpr vk::DeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+private:
+  struct Pool {
+    vk::DeviceSize blockSize;
+    std::vector<std::unique_ptr<Allocation::Block>> blocks;
+  };
+
+  const vk::raii::Device &device;
+  const vk::PhysicalDeviceMemoryProperties memoryProperties;
+
+  mutable std::mutex mutex;
+  mutable std::vector<Pool> pools;
+  mutable size_t allocationCount = 0;
+  mutable size_t totalBlocks = 0;
+  mutable size_t totalAllocations = 0;
+
+  Allocation::Block &createBlock(uint32_t memoryTypeIndex, vk::DeviceSize size, bool dedicated) const;
+
+  friend struct Allocation;
+  void free(Allocation::Block *, vk::DeviceSize offset, vk::DeviceSize size) const;
+
+public:
+  Allocator(const vk::raii::Device &, const vk::raii::PhysicalDevice &);
+  ~Allocator();
+
+  [[nodiscard]] uint32_t findMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags) const;
+  [[nodiscard]] Allocation allocate(const vk::MemoryRequirements &,
+                                    vk::MemoryPropertyFlags,
+                                    bool dedicated = false) const;
+
+  [[nodiscard]] Stats stats() const;
+};
+
+std::ostream &operator<<(std::ostream &, const Allocator::Stats &);
@@ -1,5 +1,14 @@
 #include "base.hpp"
 
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <ranges>
+#include <string_view>
+#include <vector>
+
+#include "trace.hpp"
+
 const auto REQUIRED_LAYER_NAMES = {
 #ifndef NDEBUG
     "VK_LAYER_KHRONOS_validation",
@@ -7,16 +16,61 @@ const auto REQUIRED_LAYER_NAMES = {
 };
 
 const vk::ApplicationInfo APPLICATION_INFO = {
-    .apiVersion = VK_API_VERSION_1_1,
+    .apiVersion = VK_API_VERSION_1_2,
 };
 
-vk::InstanceCreateInfo instanceCreateInfo() {
+// enabled when both are available, for present fences telling when a replaced swapchain can be destroyed
+const std::array<const char *, 2> SURFACE_MAINTENANCE_EXTENSION_NAMES = {
+    VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME,
+    VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME,
+};
+
+bool supportsSurfaceMaintenance(const vk::raii::Context &context, const vkfw::Window *window) {
+  if (!window) {
+    return false;
+  }
+  auto properties = context.enumerateInstanceExtensionProperties();
+  return std::ranges::all_of(SURFACE_MAINTENANCE_EXTENSION_NAMES, [&](std::string_view extensionName) {
+    return std::ranges::any_of(properties,
+                               [&](const auto &props) { return extensionName == props.extensionName.data(); });
+  });
+}
+
+std::vector<const char *> requiredExtensions(const vkfw::Window *window, bool surfaceMaintenance) {
+  if (!window) {
+    return {};
+  }
   // implicit dependency on vkfw::Instance
-  auto requiredExtensions = vkfw::getRequiredInstanceExtensions();
-  return vk::InstanceCreateInfo{.pApplicationInfo = &APPLICATION_INFO}
-      .setPEnabledExtensionNames(requiredExtensions)
-      .setPEnabledLayerNames(REQUIRED_LAYER_NAMES);
+  auto windowExtensions = vkfw::getRequiredInstanceExtensions();
+  std::vector<const char *> extensions(windowExtensions.begin(), windowExtensions.end());
+  if (surfaceMaintenance) {
+    std::ranges::copy(SURFACE_MAINTENANCE_EXTENSION_NAMES, std::back_inserter(extensions));
+  }
+  return extensions;
+}
+
+vk::raii::Instance createInstance(const vk::raii::Context &context,
+                                  const vkfw::Window *window,
+                                  bool surfaceMaintenance) {
+  TRACE_SCOPE("createInstance");
+  auto extensions = requiredExtensions(window, surfaceMaintenance);
+  return {
+      context,
+      vk::InstanceCreateInfo{.pApplicationInfo = &APPLICATION_INFO}
+          .setPEnabledExtensionNames(extensions)
+          .setPEnabledLayerNames(REQUIRED_LAYER_NAMES),
+  };
+}
+
+vk::raii::SurfaceKHR createSurface(const vk::raii::Instance &instance, const vkfw::Window *window) {
+  TRACE_SCOPE("createSurface");
+  if (!window) {
+    return nullptr;
+  }
+  return vk::raii::SurfaceKHR(instance, vkfw::createWindowSurface(*instance, *window));
 }
 
-Base::Base(const vkfw::Window &window)
-    : instance(context, instanceCreateInfo()), surface(instance, vkfw::createWindowSurface(*instance, window)) {}
+Base::Base(const vkfw::Window *window)
+    : surfaceMaintenance(supportsSurfaceMaintenance(context, window)),
+      instance(createInstance(context, window, surfaceMaintenance)),
+      surface(createSurface(instance, window)) {}
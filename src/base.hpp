@@ -5,8 +5,13 @@
 
 struct Base {
   const vk::raii::Context context;
+  // VK_EXT_surface_maintenance1 and VK_KHR_get_surface_capabilities2 are enabled, which
+  // VK_EXT_swapchain_maintenance1 depends on. Never with a null surface
+  const bool surfaceMaintenance;
   const vk::raii::Instance instance;
+  // null when rendering headless
   const vk::raii::SurfaceKHR surface;
 
-  Base(const vkfw::Window &window);
+  // without a window no surface extensions are requested, so no vkfw::Instance is needed either
+  Base(const vkfw::Window *window);
 };
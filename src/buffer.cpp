@@ -1,32 +1,9 @@
-#include <bitset>
-
 #include "buffer.hpp"
 
-vk::raii::DeviceMemory allocateMemory(const vk::raii::Device &device,
-                                      const vk::raii::PhysicalDevice &physicalDevice,
-                                      const vk::raii::Buffer &buffer,
-                                      vk::MemoryPropertyFlags memoryPropertyFlags) {
-  auto memoryRequirements = buffer.getMemoryRequirements();
-  std::bitset<32> memoryTypeBits = memoryRequirements.memoryTypeBits;
-
-  auto memoryProperties = physicalDevice.getMemoryProperties();
-  uint32_t memoryTypeIndex = 0;
-  for (const auto &memoryType : memoryProperties.memoryTypes) {
-    if (memoryTypeBits[memoryTypeIndex] && ((memoryType.propertyFlags & memoryPropertyFlags) == memoryPropertyFlags)) {
-      break;
-    } else {
-      memoryTypeIndex++;
-    }
-  }
-
-  return device.allocateMemory({
-      .allocationSize = memoryRequirements.size,
-      .memoryTypeIndex = memoryTypeIndex,
-  });
-}
+#include <cstring>
 
 Buffer::Buffer(const vk::raii::Device &device,
-               const vk::raii::PhysicalDevice &physicalDevice,
+               const Allocator &allocator,
                size_t size,
                vk::BufferUsageFlags usage,
                vk::MemoryPropertyFlags memoryProperties)
@@ -36,6 +13,24 @@ Buffer::Buffer(const vk::raii::Device &device,
           .usage = usage,
           .sharingMode = vk::SharingMode::eExclusive,
       })),
-      memory(allocateMemory(device, physicalDevice, buffer, memoryProperties)) {
-  buffer.bindMemory(*memory, 0);
+      allocation(allocator.allocate(buffer.getMemoryRequirements(), memoryProperties)) {
+  buffer.bindMemory(allocation.memory, allocation.offset);
+}
+
+HostBuffer::HostBuffer(const vk::raii::Device &device,
+                       const Allocator &allocator,
+                       size_t size,
+                       vk::BufferUsageFlags usage)
+    : Buffer(device,
+             allocator,
+             size,
+             usage,
+             vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible) {}
+
+HostBuffer::HostBuffer(const vk::raii::Device &device,
+                       const Allocator &allocator,
+                       std::span<const std::byte> data,
+                       vk::BufferUsageFlags usage)
+    : HostBuffer(device, allocator, data.size(), usage) {
+  memcpy(allocation.mapped, data.data(), data.size());
 }
@@ -1,45 +1,22 @@
 #pragma once
 
-#include <ranges>
+#include <span>
 
 #include <vulkan/vulkan_raii.hpp>
 
+#include "allocator.hpp"
+
 struct Buffer {
   const size_t size;
   const vk::raii::Buffer buffer;
-  const vk::raii::DeviceMemory memory;
+  const Allocation allocation;
 
-  Buffer(const vk::raii::Device &,
-         const vk::raii::PhysicalDevice &,
-         size_t,
-         vk::BufferUsageFlags,
-         vk::MemoryPropertyFlags);
+  Buffer(const vk::raii::Device &, const Allocator &, size_t, vk::BufferUsageFlags, vk::MemoryPropertyFlags);
 };
 
-template <std::ranges::contiguous_range R>
+// Host visible buffer filled with a copy of the data at construction, the source can be released straight after.
+// Constructed from a size the contents are left for the caller to write through the mapping.
 struct HostBuffer : Buffer {
-  const R data;
-
-  HostBuffer(const vk::raii::Device &, const vk::raii::PhysicalDevice &, const R &, vk::BufferUsageFlags);
-
-  void copyData() const;
-};
-
-template <typename T>
-struct DynamicHostBuffer : Buffer {
-  DynamicHostBuffer(const vk::raii::Device &, const vk::raii::PhysicalDevice &, vk::BufferUsageFlags);
-
-  void copyData(const T &data) const;
+  HostBuffer(const vk::raii::Device &, const Allocator &, size_t, vk::BufferUsageFlags);
+  HostBuffer(const vk::raii::Device &, const Allocator &, std::span<const std::byte>, vk::BufferUsageFlags);
 };
-
-template <std::ranges::contiguous_range R>
-struct StagedBuffer {
-  const HostBuffer<R> stagingBuffer;
-  const Buffer deviceBuffer;
-
-  StagedBuffer(const vk::raii::Device &, const vk::raii::PhysicalDevice &, const R &, vk::BufferUsageFlags);
-
-  void copyData(const vk::raii::Device &, const vk::raii::CommandPool &, const vk::raii::Queue &) const;
-};
-
-#include "buffer_impl.hpp"
\ No newline at end of file
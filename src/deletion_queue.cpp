@@ -0,0 +1,17 @@
+#include "deletion_queue.hpp"
+
+#include "trace.hpp"
+
+size_t DeletionQueue::collect(uint64_t completedValue) {
+  if (entries.empty() || entries.front().value > completedValue) {
+    return 0;
+  }
+  TRACE_SCOPE("DeletionQueue::collect");
+  size_t count = 0;
+  while (!entries.empty() && entries.front().value <= completedValue) {
+    entries.pop_front();
+    count++;
+  }
+  destroyed += count;
+  return count;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+
+// Keeps gpu resources alive until the frames that may still use them have completed, so replacing something the gpu
+// is reading never waits for the device to go idle. A resource is retired with the FramePacer value signalled by the
+// last frame submitted before it was replaced, and destroyed by the first collect that sees the timeline reach it.
+// Any movable type can be retired, RAII handles and the structs holding them included.
+// A timeline value only proves the gpu finished rendering, not that the presentation engine let go: resources it reads,
+// a retired swapchain's images, need a value that covers presentation, such as that of the last present released.
+// The queue compares against one counter, so every value retired and collected has to be on the same timeline.
+class DeletionQueue {
+  struct Resource {
+    virtual ~Resource() = default;
+  };
+  template <typename T>
+  struct Holder : Resource {
+    T resource;
+    explicit Holder(T &&resource) : resource(std::move(resource)) {}
+  };
+  struct Entry {
+    uint64_t value;
+    std::unique_ptr<Resource> resource;
+  };
+
+  // in retirement order, the values never decrease
+  std::deque<Entry> entries;
+  size_t destroyed = 0;
+
+public:
+  template <typename T>
+  void retire(T resource, uint64_t value) {
+    entries.push_back({
+        .value = value,
+        .resource = std::make_unique<Holder<T>>(std::move(resource)),
+    });
+  }
+  // destroys every resource retired with a value up to completedValue, returns how many
+  size_t collect(uint64_t completedValue);
+
+  [[nodiscard]] size_t pending() const { return entries.size(); }
+  [[nodiscard]] size_t destroyedCount() const { return destroyed; }
+};
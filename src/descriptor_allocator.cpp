@@ -0,0 +1,127 @@
+#include "descriptor_allocator.hpp"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include "trace.hpp"
+
+// pools stop doubling at this many sets
+const uint32_t MAX_POOL_SETS = 4096;
+
+std::vector<vk::DescriptorPoolSize> descriptorsPerSet(
+    std::initializer_list<std::span<const vk::DescriptorSetLayoutBinding>> layouts) {
+  std::map<vk::DescriptorType, uint32_t> most;
+  for (auto bindings : layouts) {
+    std::map<vk::DescriptorType, uint32_t> counts;
+    for (const auto &binding : bindings) {
+      counts[binding.descriptorType] += binding.descriptorCount;
+    }
+    for (auto [type, count] : counts) {
+      most[type] = std::max(most[type], count);
+    }
+  }
+  std::vector<vk::DescriptorPoolSize> result;
+  for (auto [type, count] : most) {
+    result.push_back({
+        .type = type,
+        .descriptorCount = count,
+    });
+  }
+  return result;
+}
+
+vk::raii::DescriptorPool createGrowablePool(const vk::raii::Device &device,
+                                            std::span<const vk::DescriptorPoolSize> descriptorsPerSet,
+                                            uint32_t maxSets) {
+  std::vector<vk::DescriptorPoolSize> poolSizes;
+  for (auto size : descriptorsPerSet) {
+    poolSizes.push_back({
+        .type = size.type,
+        .descriptorCount = size.descriptorCount * maxSets,
+    });
+  }
+  return device.createDescriptorPool(vk::DescriptorPoolCreateInfo{
+      .maxSets = maxSets,
+  }
+                                         .setPoolSizes(poolSizes));
+}
+
+DescriptorAllocator::DescriptorAllocator(const vk::raii::Device &device,
+                                         std::vector<vk::DescriptorPoolSize> descriptorsPerSet,
+                                         uint32_t initialPoolSets)
+    : device(device), descriptorsPerSet(std::move(descriptorsPerSet)), nextPoolSets(initialPoolSets) {}
+
+void DescriptorAllocator::nextPool() {
+  if (!freePools.empty()) {
+    pools.push_back(std::move(freePools.back()));
+    freePools.pop_back();
+    return;
+  }
+  TRACE_SCOPE("DescriptorAllocator::grow");
+  pools.push_back(createGrowablePool(device, descriptorsPerSet, nextPoolSets));
+  poolsCreated++;
+  nextPoolSets = std::min(nextPoolSets * 2, MAX_POOL_SETS);
+}
+
+vk::DescriptorSet DescriptorAllocator::allocate(const vk::raii::DescriptorSetLayout &layout) {
+  if (pools.empty()) {
+    nextPool();
+  }
+  // called through the raw entry point, running out of pool memory is expected and not worth an exception
+  auto allocateFrom = [&](const vk::raii::DescriptorPool &pool, VkDescriptorSet &set) {
+    auto setLayout = static_cast<VkDescriptorSetLayout>(*layout);
+    auto allocateInfo = VkDescriptorSetAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = static_cast<VkDescriptorPool>(*pool),
+        .descriptorSetCount = 1,
+        .pSetLayouts = &setLayout,
+    };
+    return device.getDispatcher()->vkAllocateDescriptorSets(static_cast<VkDevice>(*device), &allocateInfo, &set);
+  };
+
+  VkDescriptorSet set = VK_NULL_HANDLE;
+  auto result = allocateFrom(pools.back(), set);
+  if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+    nextPool();
+    result = allocateFrom(pools.back(), set);
+  }
+  if (result != VK_SUCCESS) {
+    throw std::runtime_error("Failed to allocate descriptor set");
+  }
+  setsAllocated++;
+  return set;
+}
+
+void DescriptorAllocator::reset() {
+  for (auto &pool : pools) {
+    pool.reset();
+    freePools.push_back(std::move(pool));
+  }
+  pools.clear();
+  setsAllocated = 0;
+}
+
+FrameDescriptorAllocator::FrameDescriptorAllocator(const vk::raii::Device &device,
+                                                   const std::vector<vk::DescriptorPoolSize> &descriptorsPerSet,
+                                                   size_t frameCount) {
+  frames.reserve(frameCount);
+  for (size_t i = 0; i < frameCount; i++) {
+    frames.emplace_back(device, descriptorsPerSet);
+  }
+}
+
+void FrameDescriptorAllocator::beginFrame(size_t frameIndex) {
+  lastFrameSets = frames[this->frameIndex].setCount();
+  this->frameIndex = frameIndex;
+  frames[frameIndex].reset();
+}
+
+size_t FrameDescriptorAllocator::poolCount() const {
+  size_t count = 0;
+  for (const auto &frame : frames) {
+    count += frame.poolCount();
+  }
+  return count;
+}
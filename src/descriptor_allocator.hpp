@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+// Hands out descriptor sets from a chain of pools, creating a pool twice the size of the last whenever the current one
+// runs out, so any number of sets and bindings can be allocated without sizing a pool up front. Sets aren't freed one
+// at a time: reset releases all of them together and keeps the pools for reuse. Pools hold the descriptor types of the
+// layouts the allocator is made for, as many per set as the most demanding of them needs.
+class DescriptorAllocator {
+  const vk::raii::Device &device;
+  const std::vector<vk::DescriptorPoolSize> descriptorsPerSet;
+  // the last one is allocated from
+  std::vector<vk::raii::DescriptorPool> pools;
+  // reset and waiting to be reused before anything new is created
+  std::vector<vk::raii::DescriptorPool> freePools;
+  uint32_t nextPoolSets;
+  size_t poolsCreated = 0;
+  size_t setsAllocated = 0;
+
+  void nextPool();
+
+public:
+  // descriptorsPerSet as descriptorsPerSet() below returns for the layouts that will be allocated
+  DescriptorAllocator(const vk::raii::Device &,
+                      std::vector<vk::DescriptorPoolSize> descriptorsPerSet,
+                      uint32_t initialPoolSets = 16);
+
+  // owned by the allocator, valid until the next reset
+  vk::DescriptorSet allocate(const vk::raii::DescriptorSetLayout &);
+  // every set allocated so far must no longer be in use by the gpu
+  void reset();
+
+  // pools created over the allocator's lifetime, each one beyond the first is a growth step
+  [[nodiscard]] size_t poolCount() const { return poolsCreated; }
+  // since the last reset
+  [[nodiscard]] size_t setCount() const { return setsAllocated; }
+};
+
+// descriptors of each type a set with any of the layouts' bindings needs at most, pools are sized in multiples of it
+std::vector<vk::DescriptorPoolSize> descriptorsPerSet(
+    std::initializer_list<std::span<const vk::DescriptorSetLayoutBinding>> layouts);
+
+// One DescriptorAllocator per frame in flight for sets written every frame. A frame's pools are reset when it begins,
+// after the pacer confirmed the gpu finished the frame that last used them.
+class FrameDescriptorAllocator {
+  std::vector<DescriptorAllocator> frames;
+  size_t frameIndex = 0;
+  size_t lastFrameSets = 0;
+
+public:
+  FrameDescriptorAllocator(const vk::raii::Device &,
+                           const std::vector<vk::DescriptorPoolSize> &descriptorsPerSet,
+                           size_t frameCount);
+
+  void beginFrame(size_t frameIndex);
+  // valid until the frame index comes around again
+  vk::DescriptorSet allocate(const vk::raii::DescriptorSetLayout &layout) {
+    return frames[frameIndex].allocate(layout);
+  }
+
+  // summed over the frames in flight
+  [[nodiscard]] size_t poolCount() const;
+  // allocated by the frame that ended when the current one began
+  [[nodiscard]] size_t setsLastFrame() const { return lastFrameSets; }
+};
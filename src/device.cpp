@@ -4,7 +4,17 @@
 #include <ranges>
 #include <unordered_set>
 
-const std::array<const char *, 1> REQUIRED_DEVICE_EXTENSION_NAMES = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+#include "trace.hpp"
+
+const std::array<const char *, 1> PRESENT_DEVICE_EXTENSION_NAMES = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+// enabled when both are available, for measuring and bounding presentation latency
+const std::array<const char *, 2> PRESENT_WAIT_EXTENSION_NAMES = {
+    VK_KHR_PRESENT_ID_EXTENSION_NAME,
+    VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+};
+// enabled when available and the instance enabled VK_EXT_surface_maintenance1, for destroying replaced swapchains
+const std::array<const char *, 1> PRESENT_FENCE_EXTENSION_NAMES = {VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME};
+const vk::SurfaceFormatKHR HEADLESS_FORMAT = {vk::Format::eB8G8R8A8Srgb, vk::ColorSpaceKHR::eSrgbNonlinear};
 const std::array<float, 1> QUEUE_PRIORITIES = {1.0};
 
 vk::SurfaceFormatKHR pickSurfaceFormat(const std::vector<vk::SurfaceFormatKHR> &formats) {
@@ -17,18 +27,75 @@ vk::SurfaceFormatKHR pickSurfaceFormat(const std::vector<vk::SurfaceFormatKHR> &
   }
 }
 
-vk::PresentModeKHR pickPresentMode(const std::vector<vk::PresentModeKHR> &presentModes) {
-  auto preferredMode = vk::PresentModeKHR::eMailbox;
-  auto presentMode = std::ranges::find(presentModes, preferredMode);
-  if (presentMode != presentModes.end()) {
-    return *presentMode;
-  } else {
-    return vk::PresentModeKHR::eFifo;
+// frames are paced with a timeline semaphore
+bool supportsRequiredFeatures(const vk::raii::PhysicalDevice &physicalDevice) {
+  if (physicalDevice.getProperties().apiVersion < VK_API_VERSION_1_2) {
+    return false;
+  }
+  auto features = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+  return features.get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore;
+}
+
+bool supportsIndirectCount(const vk::raii::PhysicalDevice &physicalDevice) {
+  auto features = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+  const auto &core = features.get<vk::PhysicalDeviceFeatures2>().features;
+  return core.multiDrawIndirect && core.drawIndirectFirstInstance &&
+         features.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount;
+}
+
+bool supportsPresentWait(const vk::raii::PhysicalDevice &physicalDevice,
+                         const std::unordered_set<std::string> &availableExtensionNames) {
+  for (auto extensionName : PRESENT_WAIT_EXTENSION_NAMES) {
+    if (!availableExtensionNames.contains(extensionName)) {
+      return false;
+    }
+  }
+  auto features = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2,
+                                              vk::PhysicalDevicePresentIdFeaturesKHR,
+                                              vk::PhysicalDevicePresentWaitFeaturesKHR>();
+  return features.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId &&
+         features.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+}
+
+bool supportsPresentFences(const vk::raii::PhysicalDevice &physicalDevice,
+                           const std::unordered_set<std::string> &availableExtensionNames) {
+  for (auto extensionName : PRESENT_FENCE_EXTENSION_NAMES) {
+    if (!availableExtensionNames.contains(extensionName)) {
+      return false;
+    }
   }
+  auto features =
+      physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>();
+  return features.get<vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>().swapchainMaintenance1;
+}
+
+// prefers a family of dma engines that only copy, then any without graphics
+uint32_t pickTransferQueueFamily(const std::vector<vk::QueueFamilyProperties> &queueFamilies,
+                                 uint32_t graphicsQueueFamilyIndex) {
+  auto transferOnly = std::ranges::find_if(queueFamilies, [](const auto &queueFamily) {
+    return (queueFamily.queueFlags & vk::QueueFlagBits::eTransfer) &&
+           !(queueFamily.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute));
+  });
+  if (transferOnly != queueFamilies.end()) {
+    return static_cast<uint32_t>(std::distance(queueFamilies.begin(), transferOnly));
+  }
+  auto withoutGraphics = std::ranges::find_if(queueFamilies, [](const auto &queueFamily) {
+    return (queueFamily.queueFlags & (vk::QueueFlagBits::eTransfer | vk::QueueFlagBits::eCompute)) &&
+           !(queueFamily.queueFlags & vk::QueueFlagBits::eGraphics);
+  });
+  if (withoutGraphics != queueFamilies.end()) {
+    return static_cast<uint32_t>(std::distance(queueFamilies.begin(), withoutGraphics));
+  }
+  return graphicsQueueFamilyIndex;
 }
 
 std::optional<Device::Details> isSuitable(const vk::raii::PhysicalDevice &physicalDevice,
-                                          const vk::raii::SurfaceKHR &surface) {
+                                          const vk::raii::SurfaceKHR &surface,
+                                          bool surfaceMaintenance) {
+  if (!supportsRequiredFeatures(physicalDevice)) {
+    return std::nullopt;
+  }
+
   auto deviceExtensionsProperties = physicalDevice.enumerateDeviceExtensionProperties();
 
   // supports required extensions
@@ -36,21 +103,47 @@ std::optional<Device::Details> isSuitable(const vk::raii::PhysicalDevice &physic
   std::ranges::transform(deviceExtensionsProperties,
                          std::inserter(availableExtensionNames, availableExtensionNames.begin()),
                          [](const auto &props) { return props.extensionName; });
-  for (auto extensionName : REQUIRED_DEVICE_EXTENSION_NAMES) {
+  std::vector<const char *> extensionNames;
+  if (*surface) {
+    std::ranges::copy(PRESENT_DEVICE_EXTENSION_NAMES, std::back_inserter(extensionNames));
+  }
+  for (auto extensionName : extensionNames) {
     if (!availableExtensionNames.contains(extensionName)) {
       return std::nullopt;
     }
   }
 
-  // has a suitable queue family
+  // has a suitable queue family, compute too since the gpu culling pass dispatches on the graphics queue. Vulkan
+  // guarantees a family with both wherever there is one with graphics
   auto queueFamilies = physicalDevice.getQueueFamilyProperties();
   auto queueFamily = std::ranges::find_if(queueFamilies, [](const auto &queueFamily) {
-    return static_cast<bool>(queueFamily.queueFlags & vk::QueueFlagBits::eGraphics);
+    auto required = vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute;
+    return (queueFamily.queueFlags & required) == required;
   });
   if (queueFamily == queueFamilies.end()) {
     return std::nullopt;
   }
   uint32_t queueFamilyIndex = std::distance(queueFamilies.begin(), queueFamily);
+  auto transferQueueFamilyIndex = pickTransferQueueFamily(queueFamilies, queueFamilyIndex);
+
+  if (!*surface) {
+    auto formatProperties = physicalDevice.getFormatProperties(HEADLESS_FORMAT.format);
+    if (!(formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eColorAttachment)) {
+      return std::nullopt;
+    }
+    return Device::Details{
+        .queueFamilyIndex = queueFamilyIndex,
+        .transferQueueFamilyIndex = transferQueueFamilyIndex,
+        .physicalDevice = physicalDevice,
+        .properties = physicalDevice.getProperties(),
+        .format = HEADLESS_FORMAT,
+        .presentModes = {vk::PresentModeKHR::eFifo},
+        .extensionNames = extensionNames,
+        .indirectCount = supportsIndirectCount(physicalDevice),
+        .presentWait = false,
+        .presentFences = false,
+    };
+  }
 
   // supports surface
   auto surfaceFormats = physicalDevice.getSurfaceFormatsKHR(*surface);
@@ -60,17 +153,33 @@ std::optional<Device::Details> isSuitable(const vk::raii::PhysicalDevice &physic
     return std::nullopt;
   }
 
+  auto presentWait = supportsPresentWait(physicalDevice, availableExtensionNames);
+  if (presentWait) {
+    std::ranges::copy(PRESENT_WAIT_EXTENSION_NAMES, std::back_inserter(extensionNames));
+  }
+  auto presentFences = surfaceMaintenance && supportsPresentFences(physicalDevice, availableExtensionNames);
+  if (presentFences) {
+    std::ranges::copy(PRESENT_FENCE_EXTENSION_NAMES, std::back_inserter(extensionNames));
+  }
+
   return Device::Details{
       .queueFamilyIndex = queueFamilyIndex,
+      .transferQueueFamilyIndex = transferQueueFamilyIndex,
       .physicalDevice = physicalDevice,
+      .properties = physicalDevice.getProperties(),
       .format = pickSurfaceFormat(surfaceFormats),
-      .presentMode = pickPresentMode(presentModes),
+      .presentModes = presentModes,
+      .extensionNames = extensionNames,
+      .indirectCount = supportsIndirectCount(physicalDevice),
+      .presentWait = presentWait,
+      .presentFences = presentFences,
   };
 }
 
-Device::Details findSuitableDevice(const vk::raii::Instance &instance, const vk::raii::SurfaceKHR &surface) {
-  for (const auto &physicalDevice : instance.enumeratePhysicalDevices()) {
-    if (auto details = isSuitable(physicalDevice, surface)) {
+Device::Details findSuitableDevice(const Base &base) {
+  TRACE_SCOPE("findSuitableDevice");
+  for (const auto &physicalDevice : base.instance.enumeratePhysicalDevices()) {
+    if (auto details = isSuitable(physicalDevice, base.surface, base.surfaceMaintenance)) {
       return *details;
     }
   }
@@ -78,60 +187,76 @@ Device::Details findSuitableDevice(const vk::raii::Instance &instance, const vk:
 }
 
 vk::raii::Device createDevice(const Device::Details &details) {
-  auto queueCreateInfos = {
+  TRACE_SCOPE("createDevice");
+  std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos = {
       vk::DeviceQueueCreateInfo{
           .queueFamilyIndex = details.queueFamilyIndex,
           .queueCount = 1,
       }
           .setQueuePriorities(QUEUE_PRIORITIES),
   };
-  return {
-      details.physicalDevice,
-      vk::DeviceCreateInfo{}
-          .setPEnabledExtensionNames(REQUIRED_DEVICE_EXTENSION_NAMES)
-          .setQueueCreateInfos(queueCreateInfos),
+  if (details.transferQueueFamilyIndex != details.queueFamilyIndex) {
+    queueCreateInfos.push_back(vk::DeviceQueueCreateInfo{
+        .queueFamilyIndex = details.transferQueueFamilyIndex,
+        .queueCount = 1,
+    }
+                                   .setQueuePriorities(QUEUE_PRIORITIES));
+  }
+  // optional features are enabled whenever they are supported
+  auto features = vk::PhysicalDeviceFeatures{
+      .multiDrawIndirect = details.indirectCount,
+      .drawIndirectFirstInstance = details.indirectCount,
   };
+  vk::StructureChain<vk::DeviceCreateInfo,
+                     vk::PhysicalDeviceVulkan12Features,
+                     vk::PhysicalDevicePresentIdFeaturesKHR,
+                     vk::PhysicalDevicePresentWaitFeaturesKHR,
+                     vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>
+      createInfo = {
+          vk::DeviceCreateInfo{}
+              .setPEnabledExtensionNames(details.extensionNames)
+              .setQueueCreateInfos(queueCreateInfos)
+              .setPEnabledFeatures(&features),
+          vk::PhysicalDeviceVulkan12Features{
+              .drawIndirectCount = details.indirectCount,
+              .timelineSemaphore = VK_TRUE,
+          },
+          vk::PhysicalDevicePresentIdFeaturesKHR{.presentId = VK_TRUE},
+          vk::PhysicalDevicePresentWaitFeaturesKHR{.presentWait = VK_TRUE},
+          vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT{.swapchainMaintenance1 = VK_TRUE},
+      };
+  if (!details.presentWait) {
+    createInfo.unlink<vk::PhysicalDevicePresentIdFeaturesKHR>();
+    createInfo.unlink<vk::PhysicalDevicePresentWaitFeaturesKHR>();
+  }
+  if (!details.presentFences) {
+    createInfo.unlink<vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>();
+  }
+  return {details.physicalDevice, createInfo.get<vk::DeviceCreateInfo>()};
 }
 
-vk::raii::DescriptorPool createDescriptorPool(const vk::raii::Device &device) {
-  auto poolSizes = {vk::DescriptorPoolSize{.descriptorCount = 2}};
-  auto createInfo =
-      vk::DescriptorPoolCreateInfo{
-          .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
-          .maxSets = 2,
-      }
-          .setPoolSizes(poolSizes);
-  return device.createDescriptorPool(createInfo);
-}
-
-Device::Device(const vk::raii::Instance &instance, const vk::raii::SurfaceKHR &surface)
-    : details(findSuitableDevice(instance, surface)),
+Device::Device(const Base &base)
+    : details(findSuitableDevice(base)),
       handle(createDevice(details)),
+      allocator(handle, details.physicalDevice),
       queue(handle.getQueue(details.queueFamilyIndex, 0)),
+      transferQueue(handle.getQueue(details.transferQueueFamilyIndex, 0)),
       commandPool(handle.createCommandPool({
           .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
           .queueFamilyIndex = details.queueFamilyIndex,
-      })),
-      descriptorPool(createDescriptorPool(handle)) {}
+      })) {}
 
-std::array<Frame, 2> Device::createFrames(const vk::raii::DescriptorSetLayout &descriptorSetLayout) const {
+std::vector<Frame> Device::createFrames(size_t count) const {
+  TRACE_SCOPE("Device::createFrames");
   auto commandBuffers = handle.allocateCommandBuffers({
       .commandPool = *commandPool,
       .level = vk::CommandBufferLevel::ePrimary,
-      .commandBufferCount = 2,
+      .commandBufferCount = static_cast<uint32_t>(count),
   });
-  auto descriptorSetLayouts = {
-      *descriptorSetLayout,
-      *descriptorSetLayout,
-  };
-
-  auto descriptorSetAllocateInfo =
-      vk::DescriptorSetAllocateInfo{
-          .descriptorPool = *descriptorPool,
-      }
-          .setSetLayouts(descriptorSetLayouts);
-  auto descriptorSets = handle.allocateDescriptorSets(descriptorSetAllocateInfo);
-
-  return {Frame(std::move(commandBuffers[0]), std::move(descriptorSets[0]), handle, details.physicalDevice),
-          Frame(std::move(commandBuffers[1]), std::move(descriptorSets[1]), handle, details.physicalDevice)};
+  std::vector<Frame> frames;
+  frames.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    frames.emplace_back(std::move(commandBuffers[i]), handle);
+  }
+  return frames;
 }
@@ -1,26 +1,44 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include <vulkan/vulkan_raii.hpp>
 
+#include "allocator.hpp"
+#include "base.hpp"
 #include "frame.hpp"
 
 struct Device {
   struct Details {
+    // graphics and compute, the queue everything but uploads is submitted to
     const uint32_t queueFamilyIndex;
+    // a transfer only family when the device has one, uploads then run beside rendering. Otherwise queueFamilyIndex
+    const uint32_t transferQueueFamilyIndex;
     const vk::raii::PhysicalDevice physicalDevice;
+    const vk::PhysicalDeviceProperties properties;
     const vk::SurfaceFormatKHR format;
-    const vk::PresentModeKHR presentMode;
+    // supported by the surface, the swapchain picks one according to its PresentPolicy
+    const std::vector<vk::PresentModeKHR> presentModes;
+    const std::vector<const char *> extensionNames;
+    // drawIndexedIndirectCount of many commands with a first instance each, which the gpu culling path draws with
+    const bool indirectCount;
+    // VK_KHR_present_id and VK_KHR_present_wait, presents carry ids the cpu can wait for until they reach the screen
+    const bool presentWait;
+    // VK_EXT_swapchain_maintenance1, presents signal a fence once the presentation engine let go of their swapchain
+    const bool presentFences;
   };
 
   const Details details;
   const vk::raii::Device handle;
+  const Allocator allocator;
   const vk::raii::Queue queue;
+  // the same queue as queue unless Details::transferQueueFamilyIndex names a family of its own
+  const vk::raii::Queue transferQueue;
   const vk::raii::CommandPool commandPool;
-  const vk::raii::DescriptorPool descriptorPool;
 
-  Device(const vk::raii::Instance &, const vk::raii::SurfaceKHR &);
+  // a base without a surface selects a device for headless rendering
+  explicit Device(const Base &);
 
-  [[nodiscard]] std::array<Frame, 2> createFrames(const vk::raii::DescriptorSetLayout &) const;
+  [[nodiscard]] std::vector<Frame> createFrames(size_t count) const;
 };
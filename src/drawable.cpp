@@ -1,14 +1,198 @@
 #include "drawable.hpp"
 
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+const vk::MemoryPropertyFlags DEVICE_LOCAL = vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+Uploader::Ticket uploadGeometry(Uploader &uploader,
+                                const std::function<void(std::span<std::byte>)> &writeVertices,
+                                const Buffer &vertexBuffer,
+                                const std::function<void(std::span<std::byte>)> &writeIndices,
+                                const Buffer &indexBuffer) {
+  writeVertices(uploader.stage(vertexBuffer).second);
+  auto [ticket, indexStaging] = uploader.stage(indexBuffer);
+  writeIndices(indexStaging);
+  return ticket;
+}
+
+std::function<void(std::span<std::byte>)> copyBytes(std::span<const std::byte> source) {
+  return [source](std::span<std::byte> staging) { std::memcpy(staging.data(), source.data(), source.size_bytes()); };
+}
+
+// zero sized buffers are invalid usage, empty geometry is rejected before anything is created
+vk::DeviceSize requireBytes(vk::DeviceSize size, const char *what) {
+  if (size == 0) {
+    throw std::runtime_error(std::string("Mesh has no ") + what);
+  }
+  return size;
+}
+
+size_t indexSize(vk::IndexType indexType) {
+  return indexType == vk::IndexType::eUint16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+vk::DeviceSize vertexBytes(size_t vertexCount, VertexFormat format) {
+  return vertexCount * vertexFormatInfo(format).bindingDescription.stride;
+}
+
+// float vertices are copied as they are, packed formats are quantized one vertex at a time
+void packVertices(std::span<const Vertex> vertices, VertexFormat format, std::span<std::byte> staging) {
+  if (format == VertexFormat::eFloat) {
+    std::memcpy(staging.data(), vertices.data(), vertices.size_bytes());
+  } else {
+    vertexFormatInfo(format).pack(vertices, staging);
+  }
+}
+
+vk::IndexType narrowestIndexType(size_t vertexCount) {
+  return vertexCount <= std::numeric_limits<uint16_t>::max() + 1ull ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+}
+
+void writeIndices(std::span<const uint32_t> indices, vk::IndexType indexType, std::span<std::byte> staging) {
+  if (indexType == vk::IndexType::eUint32) {
+    std::memcpy(staging.data(), indices.data(), indices.size_bytes());
+    return;
+  }
+  for (size_t i = 0; i < indices.size(); i++) {
+    auto narrowed = static_cast<uint16_t>(indices[i]);
+    std::memcpy(staging.data() + i * sizeof(narrowed), &narrowed, sizeof(narrowed));
+  }
+}
+
+bool storedAs(const MeshFile &mesh, VertexFormat format) {
+  const auto &info = vertexFormatInfo(format);
+  return mesh.hasLayout(info.bindingDescription.stride, info.attributeDescriptions);
+}
+
+vk::DeviceSize meshVertexBytes(const MeshFile &mesh, VertexFormat format) {
+  if (!storedAs(mesh, format) && !storedAs(mesh, VertexFormat::eFloat)) {
+    throw std::runtime_error("Mesh vertex layout can't be converted to the pipeline's");
+  }
+  return vertexBytes(mesh.header.vertexCount, format);
+}
+
+void writeMeshVertices(const MeshFile &mesh, VertexFormat format, std::span<std::byte> staging) {
+  if (storedAs(mesh, format)) {
+    std::memcpy(staging.data(), mesh.vertices.data(), mesh.vertices.size_bytes());
+    return;
+  }
+  // the vertex block is 16 byte aligned within a page aligned mapping, so it can be read as Vertices in place
+  std::span<const Vertex> vertices(reinterpret_cast<const Vertex *>(mesh.vertices.data()), mesh.header.vertexCount);
+  packVertices(vertices, format, staging);
+}
+
+DrawableBuffers::DrawableBuffers(const vk::raii::Device &device,
+                                 const Allocator &allocator,
+                                 Uploader &uploader,
+                                 vk::DeviceSize vertexBytes,
+                                 const Writer &writeVertices,
+                                 vk::DeviceSize indexBytes,
+                                 const Writer &writeIndices,
+                                 vk::IndexType indexType,
+                                 glm::vec4 bounds)
+    : vertexBuffer(device,
+                   allocator,
+                   requireBytes(vertexBytes, "vertices"),
+                   vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
+                   DEVICE_LOCAL),
+      indexBuffer(device,
+                  allocator,
+                  requireBytes(indexBytes, "indices"),
+                  vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
+                  DEVICE_LOCAL),
+      indexType(indexType),
+      indexCount(static_cast<uint32_t>(indexBytes / indexSize(indexType))),
+      bounds(bounds),
+      ticket(uploadGeometry(uploader, writeVertices, vertexBuffer, writeIndices, indexBuffer)) {}
+
+DrawableBuffers::DrawableBuffers(const vk::raii::Device &device,
+                                 const Allocator &allocator,
+                                 Uploader &uploader,
+                                 std::span<const std::byte> vertices,
+                                 std::span<const std::byte> indices,
+                                 vk::IndexType indexType,
+                                 VertexFormat format)
+    : DrawableBuffers(device,
+                      allocator,
+                      uploader,
+                      vertices.size_bytes(),
+                      copyBytes(vertices),
+                      indices.size_bytes(),
+                      copyBytes(indices),
+                      indexType,
+                      boundingSphere(vertices, format)) {}
+
+DrawableBuffers::DrawableBuffers(const vk::raii::Device &device,
+                                 const Allocator &allocator,
+                                 Uploader &uploader,
+                                 std::span<const Vertex> vertices,
+                                 std::span<const Index> indices,
+                                 VertexFormat format)
+    : DrawableBuffers(
+          device,
+          allocator,
+          uploader,
+          vertexBytes(vertices.size(), format),
+          [&](std::span<std::byte> staging) { packVertices(vertices, format, staging); },
+          indices.size_bytes(),
+          copyBytes(std::as_bytes(indices)),
+          INDEX_TYPE,
+          boundingSphere(std::as_bytes(vertices), VertexFormat::eFloat)) {}
+
+DrawableBuffers::DrawableBuffers(const vk::raii::Device &device,
+                                 const Allocator &allocator,
+                                 Uploader &uploader,
+                                 const Drawable &drawable,
+                                 VertexFormat format)
+    : DrawableBuffers(device, allocator, uploader, drawable.vertices, drawable.indices, format) {}
+
 DrawableBuffers::DrawableBuffers(const vk::raii::Device &device,
-                                 const vk::raii::PhysicalDevice &physicalDevice,
-                                 const Drawable &drawable)
-    : vertexBuffer(device, physicalDevice, drawable.vertices, vk::BufferUsageFlagBits::eVertexBuffer),
-      indexBuffer(device, physicalDevice, drawable.indices, vk::BufferUsageFlagBits::eIndexBuffer) {}
+                                 const Allocator &allocator,
+                                 Uploader &uploader,
+                                 const MeshFile &mesh,
+                                 VertexFormat format)
+    : DrawableBuffers(
+          device,
+          allocator,
+          uploader,
+          meshVertexBytes(mesh, format),
+          [&](std::span<std::byte> staging) { writeMeshVertices(mesh, format, staging); },
+          mesh.indices.size_bytes(),
+          copyBytes(mesh.indices),
+          mesh.indexType(),
+          boundingSphere(mesh.vertices, mesh.vertexFormat().value_or(VertexFormat::eFloat))) {}
+
+DrawableBuffers::DrawableBuffers(const vk::raii::Device &device,
+                                 const Allocator &allocator,
+                                 Uploader &uploader,
+                                 const MeshData &mesh,
+                                 VertexFormat format)
+    : DrawableBuffers(
+          device,
+          allocator,
+          uploader,
+          vertexBytes(mesh.vertices.size(), format),
+          [&](std::span<std::byte> staging) { packVertices(mesh.vertices, format, staging); },
+          mesh.indices.size() * indexSize(narrowestIndexType(mesh.vertices.size())),
+          [&](std::span<std::byte> staging) {
+            writeIndices(mesh.indices, narrowestIndexType(mesh.vertices.size()), staging);
+          },
+          narrowestIndexType(mesh.vertices.size()),
+          boundingSphere(std::as_bytes(std::span(mesh.vertices)), VertexFormat::eFloat)) {}
+
+void DrawableBuffers::bind(const vk::raii::CommandBuffer &commandBuffer) const {
+  commandBuffer.bindVertexBuffers(0, {*vertexBuffer.buffer}, {0});
+  commandBuffer.bindIndexBuffer(*indexBuffer.buffer, 0, indexType);
+}
 
-void DrawableBuffers::copyData(const vk::raii::Device &device,
-                               const vk::raii::CommandPool &commandPool,
-                               const vk::raii::Queue &queue) const {
-  vertexBuffer.copyData(device, commandPool, queue);
-  indexBuffer.copyData(device, commandPool, queue);
+void DrawableBuffers::drawInstanced(const vk::raii::CommandBuffer &commandBuffer,
+                                    const vk::raii::Buffer &instanceBuffer,
+                                    vk::DeviceSize instanceOffset,
+                                    uint32_t instanceCount) const {
+  bind(commandBuffer);
+  commandBuffer.bindVertexBuffers(1, {*instanceBuffer}, {instanceOffset});
+  commandBuffer.drawIndexed(indexCount, instanceCount, 0, 0, 0);
 }
@@ -1,18 +1,84 @@
 #pragma once
 
+#include <functional>
+#include <span>
+#include <vector>
+
 #include "buffer.hpp"
+#include "mesh_file.hpp"
+#include "mesh_optimizer.hpp"
 #include "pipeline.hpp"
+#include "uploader.hpp"
 
 struct Drawable {
   const std::vector<Vertex> vertices;
   const std::vector<Index> indices;
 };
 
+// Device local geometry, the source data is only borrowed while it is written to staging memory. Meshes without
+// vertices or indices throw.
 struct DrawableBuffers {
-  const StagedBuffer<std::vector<Vertex>> vertexBuffer;
-  const StagedBuffer<std::vector<Index>> indexBuffer;
+  const Buffer vertexBuffer;
+  const Buffer indexBuffer;
+  const vk::IndexType indexType;
+  const uint32_t indexCount;
+  // bounding sphere of the vertices, xyz center and w radius
+  const glm::vec4 bounds;
+  const Uploader::Ticket ticket;
+
+  // vertices already in the given format, indices of the given type
+  DrawableBuffers(const vk::raii::Device &,
+                  const Allocator &,
+                  Uploader &,
+                  std::span<const std::byte> vertices,
+                  std::span<const std::byte> indices,
+                  vk::IndexType,
+                  VertexFormat = VertexFormat::eFloat);
+  // quantizes the vertices to the format while writing them to staging memory
+  DrawableBuffers(const vk::raii::Device &,
+                  const Allocator &,
+                  Uploader &,
+                  std::span<const Vertex>,
+                  std::span<const Index>,
+                  VertexFormat = VertexFormat::eFloat);
+  DrawableBuffers(const vk::raii::Device &,
+                  const Allocator &,
+                  Uploader &,
+                  const Drawable &,
+                  VertexFormat = VertexFormat::eFloat);
+  // copies straight from the mapping when the file is stored in the format, float files are quantized on load and
+  // any other layout throws
+  DrawableBuffers(const vk::raii::Device &,
+                  const Allocator &,
+                  Uploader &,
+                  const MeshFile &,
+                  VertexFormat = VertexFormat::eFloat);
+  // indices are narrowed to 16 bits whenever the vertex count allows it
+  DrawableBuffers(const vk::raii::Device &,
+                  const Allocator &,
+                  Uploader &,
+                  const MeshData &,
+                  VertexFormat = VertexFormat::eFloat);
 
-  DrawableBuffers(const vk::raii::Device &, const vk::raii::PhysicalDevice &, const Drawable &);
+  // binds the geometry to the first vertex binding
+  void bind(const vk::raii::CommandBuffer &) const;
+  // draws instanceCount copies of the mesh in one call, instance attributes are read from the second vertex binding
+  void drawInstanced(const vk::raii::CommandBuffer &,
+                     const vk::raii::Buffer &instanceBuffer,
+                     vk::DeviceSize instanceOffset,
+                     uint32_t instanceCount) const;
 
-  void copyData(const vk::raii::Device &, const vk::raii::CommandPool &, const vk::raii::Queue &) const;
-};
\ No newline at end of file
+private:
+  using Writer = std::function<void(std::span<std::byte>)>;
+
+  // the writers fill the staging memory of their buffer
+  DrawableBuffers(const vk::raii::Device &,
+                  const Allocator &,
+                  Uploader &,
+                  vk::DeviceSize vertexBytes,
+                  const Writer &writeVertices,
+                  vk::DeviceSize indexBytes,
+                  const Writer &writeIndices,
+                  vk::IndexType,
+                  glm::vec4 bounds);
+};
@@ -2,21 +2,15 @@
 
 #include <vulkan/vulkan_raii.hpp>
 
-#include "buffer.hpp"
-#include "pipeline.hpp"
+constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
 
+// Per frame in flight resources, completion is tracked by the FramePacer. Members aren't const so frames can be kept
+// in a vector sized at runtime. Descriptor sets come from the renderer's FrameDescriptorAllocator each frame.
 struct Frame {
-  const vk::raii::CommandBuffer commandBuffer;
-  const vk::raii::DescriptorSet descriptorSet;
+  vk::raii::CommandBuffer commandBuffer;
 
-  const vk::raii::Semaphore imageAvailable;
-  const vk::raii::Semaphore renderFinished;
-  const vk::raii::Fence inFlight;
+  vk::raii::Semaphore imageAvailable;
+  vk::raii::Semaphore renderFinished;
 
-  const DynamicHostBuffer<UniformBufferObject> uniformBuffer;
-
-  Frame(vk::raii::CommandBuffer &&,
-        vk::raii::DescriptorSet &&,
-        const vk::raii::Device &,
-        const vk::raii::PhysicalDevice &);
+  Frame(vk::raii::CommandBuffer &&, const vk::raii::Device &);
 };
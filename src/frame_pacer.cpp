@@ -0,0 +1,45 @@
+#include "frame_pacer.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+#include "stopwatch.hpp"
+#include "trace.hpp"
+
+vk::raii::Semaphore createTimeline(const vk::raii::Device &device) {
+  vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> createInfo = {
+      vk::SemaphoreCreateInfo{},
+      vk::SemaphoreTypeCreateInfo{
+          .semaphoreType = vk::SemaphoreType::eTimeline,
+          .initialValue = 0,
+      },
+  };
+  return device.createSemaphore(createInfo.get<vk::SemaphoreCreateInfo>());
+}
+
+FramePacer::FramePacer(const vk::raii::Device &device, size_t framesInFlight)
+    : device(device), framesInFlight(framesInFlight), timeline(createTimeline(device)) {
+  if (framesInFlight == 0) {
+    throw std::runtime_error("At least one frame in flight is required");
+  }
+}
+
+double FramePacer::waitForFrame() {
+  TRACE_SCOPE("FramePacer::waitForFrame");
+  // the first framesInFlight frames have nothing to wait for
+  if (submitted < framesInFlight) {
+    return 0.0;
+  }
+
+  Stopwatch stopwatch;
+  auto semaphores = {*timeline};
+  auto values = {static_cast<uint64_t>(submitted + 1 - framesInFlight)};
+  auto result = device.waitSemaphores(vk::SemaphoreWaitInfo{}.setSemaphores(semaphores).setValues(values),
+                                      std::numeric_limits<uint64_t>::max());
+  if (result != vk::Result::eSuccess) {
+    throw std::runtime_error("Failed waiting for frame");
+  }
+  auto elapsed = stopwatch.lap();
+  blocked += elapsed;
+  return elapsed;
+}
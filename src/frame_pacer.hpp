@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vulkan/vulkan_raii.hpp>
+
+// Paces frames on a single timeline semaphore, the submit of the n-th frame signals the value n. Before a frame slot
+// is reused the cpu waits for the frame that used it framesInFlight submits earlier, and the time spent blocked is
+// accumulated so the frame count can be tuned between throughput and latency.
+class FramePacer {
+  const vk::raii::Device &device;
+  const size_t framesInFlight;
+  const vk::raii::Semaphore timeline;
+
+  uint64_t submitted = 0;
+  double blocked = 0.0;
+
+public:
+  FramePacer(const vk::raii::Device &, size_t framesInFlight);
+
+  [[nodiscard]] size_t frameCount() const { return framesInFlight; }
+  [[nodiscard]] size_t frameIndex() const { return submitted % framesInFlight; }
+
+  // blocks until the gpu is done with the frame that last used frameIndex(), returns the milliseconds spent blocked
+  double waitForFrame();
+
+  [[nodiscard]] const vk::raii::Semaphore &semaphore() const { return timeline; }
+  // the value the next submit has to signal on semaphore()
+  [[nodiscard]] uint64_t signalValue() const { return submitted + 1; }
+  // call once the submit signalling signalValue() has been queued
+  void advance() { submitted++; }
+
+  [[nodiscard]] uint64_t framesSubmitted() const { return submitted; }
+  // the value of the last frame the gpu completed, without blocking
+  [[nodiscard]] uint64_t completedValue() const { return timeline.getCounterValue(); }
+  [[nodiscard]] double blockedMilliseconds() const { return blocked; }
+};
@@ -0,0 +1,29 @@
+#include "frustum.hpp"
+
+Frustum frustumPlanes(const glm::mat4 &clipFromSpace) {
+  // glm is column major, rows of the matrix combine into the clip planes (Gribb and Hartmann)
+  auto row = [&](int i) {
+    return glm::vec4(clipFromSpace[0][i], clipFromSpace[1][i], clipFromSpace[2][i], clipFromSpace[3][i]);
+  };
+  Frustum planes = {
+      row(3) + row(0),
+      row(3) - row(0),
+      row(3) + row(1),
+      row(3) - row(1),
+      row(2),
+      row(3) - row(2),
+  };
+  for (auto &plane : planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+  return planes;
+}
+
+bool intersects(const Frustum &frustum, const glm::vec3 &center, float radius) {
+  for (const auto &plane : frustum) {
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+// Planes as (normal, distance) with inward facing normals, so a point p is inside when dot(normal, p) + distance >= 0
+// for every plane. Normals are unit length and distances comparable to sphere radii.
+using Frustum = std::array<glm::vec4, 6>;
+
+// extracts the planes of a Vulkan clip space (depth in [0, 1]) from the matrix that maps into it, the planes are in
+// the space the matrix maps from
+Frustum frustumPlanes(const glm::mat4 &clipFromSpace);
+
+[[nodiscard]] bool intersects(const Frustum &, const glm::vec3 &center, float radius);
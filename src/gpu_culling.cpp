@@ -0,0 +1,143 @@
+#include "gpu_culling.hpp"
+
+#include <deque>
+#include <stdexcept>
+
+#include "trace.hpp"
+
+// local_size_x of cull.comp
+const uint32_t CULL_WORKGROUP_SIZE = 64;
+
+vk::DeviceSize storageSliceSize(vk::DeviceSize size, const Device &device) {
+  auto alignment = device.details.properties.limits.minStorageBufferOffsetAlignment;
+  return alignUp(size, alignment);
+}
+
+// without objects every buffer would be zero sized, which is invalid usage
+uint32_t requireObjects(size_t objectCount) {
+  if (objectCount == 0) {
+    throw std::runtime_error("GPU culling needs at least one object");
+  }
+  return static_cast<uint32_t>(objectCount);
+}
+
+std::vector<vk::DescriptorSet> allocateSets(DescriptorAllocator &descriptors,
+                                            const vk::raii::DescriptorSetLayout &layout,
+                                            size_t count) {
+  std::vector<vk::DescriptorSet> sets;
+  for (size_t i = 0; i < count; i++) {
+    sets.push_back(descriptors.allocate(layout));
+  }
+  return sets;
+}
+
+GpuCulling::GpuCulling(const Device &device,
+                       const Pipeline &pipeline,
+                       Uploader &uploader,
+                       DescriptorAllocator &descriptors,
+                       const Buffer &uniformBuffer,
+                       std::span<const InstanceData> objectData,
+                       size_t frameCount)
+    : objectCount(requireObjects(objectData.size())),
+      commandSliceSize(storageSliceSize(objectData.size() * sizeof(vk::DrawIndexedIndirectCommand), device)),
+      countSliceSize(storageSliceSize(sizeof(uint32_t), device)),
+      objects(device.handle,
+              device.allocator,
+              objectData.size_bytes(),
+              vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer,
+              vk::MemoryPropertyFlagBits::eDeviceLocal),
+      commands(device.handle,
+               device.allocator,
+               commandSliceSize * frameCount,
+               vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+               vk::MemoryPropertyFlagBits::eDeviceLocal),
+      counts(device.handle,
+             device.allocator,
+             countSliceSize * frameCount,
+             vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer |
+                 vk::BufferUsageFlagBits::eIndirectBuffer,
+             vk::MemoryPropertyFlagBits::eDeviceLocal),
+      cullSets(allocateSets(descriptors, pipeline.cullDescriptorSetLayout, frameCount)),
+      drawSet(descriptors.allocate(pipeline.indirectDescriptorSetLayout)),
+      ticket(uploader.upload(objectData, objects)) {
+  TRACE_SCOPE("GpuCulling::GpuCulling");
+  // the writes point into bufferInfos, a deque keeps them in place while it grows
+  std::deque<vk::DescriptorBufferInfo> bufferInfos;
+  std::vector<vk::WriteDescriptorSet> writes;
+  auto write = [&](vk::DescriptorSet set,
+                   uint32_t binding,
+                   vk::DescriptorType type,
+                   const vk::DescriptorBufferInfo &bufferInfo) {
+    writes.push_back(vk::WriteDescriptorSet{
+        .dstSet = set,
+        .dstBinding = binding,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = type,
+        .pBufferInfo = &bufferInfos.emplace_back(bufferInfo),
+    });
+  };
+
+  for (size_t i = 0; i < frameCount; i++) {
+    write(cullSets[i], 0, vk::DescriptorType::eStorageBuffer, {*objects.buffer, 0, VK_WHOLE_SIZE});
+    write(cullSets[i],
+          1,
+          vk::DescriptorType::eStorageBuffer,
+          {*commands.buffer, i * commandSliceSize, objectCount * sizeof(vk::DrawIndexedIndirectCommand)});
+    write(cullSets[i], 2, vk::DescriptorType::eStorageBuffer, {*counts.buffer, i * countSliceSize, sizeof(uint32_t)});
+  }
+  // the frame's slice of the uniform buffer is selected through a dynamic offset at bind time
+  write(drawSet, 0, vk::DescriptorType::eUniformBufferDynamic, {*uniformBuffer.buffer, 0, sizeof(UniformBufferObject)});
+  write(drawSet, 1, vk::DescriptorType::eStorageBuffer, {*objects.buffer, 0, VK_WHOLE_SIZE});
+  device.handle.updateDescriptorSets(writes, {});
+}
+
+void GpuCulling::cull(const vk::raii::CommandBuffer &commandBuffer,
+                      const Pipeline &pipeline,
+                      size_t frameIndex,
+                      const CullPushConstants &constants) const {
+  commandBuffer.fillBuffer(*counts.buffer, frameIndex * countSliceSize, sizeof(uint32_t), 0);
+  commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                vk::PipelineStageFlagBits::eComputeShader,
+                                {},
+                                vk::MemoryBarrier{
+                                    .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                                    .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+                                },
+                                {},
+                                {});
+
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline.cull.get());
+  commandBuffer.bindDescriptorSets(
+      vk::PipelineBindPoint::eCompute, *pipeline.cullPipelineLayout, 0, {cullSets[frameIndex]}, {});
+  commandBuffer.pushConstants<CullPushConstants>(
+      *pipeline.cullPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+  commandBuffer.dispatch((objectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+  commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                vk::PipelineStageFlagBits::eDrawIndirect,
+                                {},
+                                vk::MemoryBarrier{
+                                    .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                                    .dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead,
+                                },
+                                {},
+                                {});
+}
+
+void GpuCulling::draw(const vk::raii::CommandBuffer &commandBuffer,
+                      const Pipeline &pipeline,
+                      const DrawableBuffers &mesh,
+                      size_t frameIndex,
+                      uint32_t uniformOffset) const {
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.indirect.get());
+  commandBuffer.bindDescriptorSets(
+      vk::PipelineBindPoint::eGraphics, *pipeline.indirectPipelineLayout, 0, {drawSet}, {uniformOffset});
+  mesh.bind(commandBuffer);
+  commandBuffer.drawIndexedIndirectCount(*commands.buffer,
+                                         frameIndex * commandSliceSize,
+                                         *counts.buffer,
+                                         frameIndex * countSliceSize,
+                                         objectCount,
+                                         sizeof(vk::DrawIndexedIndirectCommand));
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "buffer.hpp"
+#include "descriptor_allocator.hpp"
+#include "device.hpp"
+#include "drawable.hpp"
+#include "pipeline.hpp"
+#include "uploader.hpp"
+
+// GPU driven drawing of many copies of one mesh. Objects live in a device local buffer uploaded once, every frame a
+// compute pass frustum culls them and writes one indexed indirect command per visible object plus a count, which a
+// single drawIndexedIndirectCount consumes. Recording costs the same whatever the object count.
+class GpuCulling {
+  const uint32_t objectCount;
+  const vk::DeviceSize commandSliceSize;
+  const vk::DeviceSize countSliceSize;
+  const Buffer objects;
+  // one slice per frame in flight, the compute pass of a frame writes while earlier frames may still draw
+  const Buffer commands;
+  const Buffer counts;
+  // owned by the DescriptorAllocator passed in, which must outlive this and never be reset
+  const std::vector<vk::DescriptorSet> cullSets;
+  const vk::DescriptorSet drawSet;
+
+public:
+  const Uploader::Ticket ticket;
+
+  // the uniform buffer is bound with a dynamic offset like the other pipelines, throws without objects
+  GpuCulling(const Device &,
+             const Pipeline &,
+             Uploader &,
+             DescriptorAllocator &,
+             const Buffer &uniformBuffer,
+             std::span<const InstanceData> objects,
+             size_t frameCount);
+
+  // resets the frame's draw count and fills its commands, recorded outside the render pass
+  void cull(const vk::raii::CommandBuffer &, const Pipeline &, size_t frameIndex, const CullPushConstants &) const;
+  // draws whatever the frame's cull pass left visible, recorded inside the render pass
+  void draw(const vk::raii::CommandBuffer &,
+            const Pipeline &,
+            const DrawableBuffers &,
+            size_t frameIndex,
+            uint32_t uniformOffset) const;
+};
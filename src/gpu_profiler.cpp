@@ -0,0 +1,84 @@
+#include "gpu_profiler.hpp"
+
+#include <numeric>
+
+uint32_t timestampValidBits(const Device &device) {
+  auto queueFamilies = device.details.physicalDevice.getQueueFamilyProperties();
+  return queueFamilies[device.details.queueFamilyIndex].timestampValidBits;
+}
+
+vk::raii::QueryPool createQueryPool(const Device &device, size_t frameCount) {
+  if (timestampValidBits(device) == 0 || device.details.properties.limits.timestampPeriod == 0.0f) {
+    return nullptr;
+  }
+  return device.handle.createQueryPool({
+      .queryType = vk::QueryType::eTimestamp,
+      .queryCount = static_cast<uint32_t>(frameCount * GpuProfiler::MAX_SCOPES_PER_FRAME * 2),
+  });
+}
+
+GpuProfiler::GpuProfiler(const Device &device, size_t frameCount)
+    : timestampPeriod(device.details.properties.limits.timestampPeriod),
+      timestampMask(timestampValidBits(device) >= 64 ? ~0ull : (1ull << timestampValidBits(device)) - 1),
+      queryPool(createQueryPool(device, frameCount)) {
+  for (size_t i = 0; i < frameCount; i++) {
+    frames.push_back({.firstQuery = static_cast<uint32_t>(i * MAX_SCOPES_PER_FRAME * 2)});
+  }
+}
+
+void GpuProfiler::collect(size_t frameIndex) {
+  auto &frame = frames[frameIndex];
+  if (!isSupported() || frame.scopes.empty()) {
+    return;
+  }
+
+  auto queryCount = static_cast<uint32_t>(frame.scopes.size() * 2);
+  auto [result, timestamps] = queryPool.getResults<uint64_t>(
+      frame.firstQuery, queryCount, queryCount * sizeof(uint64_t), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+  if (result == vk::Result::eSuccess) {
+    for (size_t i = 0; i < frame.scopes.size(); i++) {
+      auto ticks = (timestamps[2 * i + 1] - timestamps[2 * i]) & timestampMask;
+      auto &history = scopeHistory[frame.scopes[i]];
+      history.push_back(ticks * timestampPeriod / 1e6);
+      if (history.size() > HISTORY_LENGTH) {
+        history.pop_front();
+      }
+    }
+  }
+  frame.scopes.clear();
+}
+
+void GpuProfiler::begin(const vk::raii::CommandBuffer &commandBuffer, size_t frameIndex) {
+  recording = &frames[frameIndex];
+  recording->scopes.clear();
+  if (isSupported()) {
+    commandBuffer.resetQueryPool(*queryPool, recording->firstQuery, MAX_SCOPES_PER_FRAME * 2);
+  }
+}
+
+std::optional<uint32_t> GpuProfiler::beginScope(const vk::raii::CommandBuffer &commandBuffer, const char *name) {
+  if (!isSupported() || !recording || recording->scopes.size() == MAX_SCOPES_PER_FRAME) {
+    return std::nullopt;
+  }
+  auto query = recording->firstQuery + static_cast<uint32_t>(recording->scopes.size() * 2);
+  recording->scopes.push_back(name);
+  commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *queryPool, query);
+  return query;
+}
+
+double GpuProfiler::average(const std::string &scope) const {
+  auto history = scopeHistory.find(scope);
+  if (history == scopeHistory.end() || history->second.empty()) {
+    return 0.0;
+  }
+  return std::accumulate(history->second.begin(), history->second.end(), 0.0) / history->second.size();
+}
+
+GpuProfiler::Scope::Scope(GpuProfiler &profiler, const vk::raii::CommandBuffer &commandBuffer, const char *name)
+    : profiler(profiler), commandBuffer(commandBuffer), query(profiler.beginScope(commandBuffer, name)) {}
+
+GpuProfiler::Scope::~Scope() {
+  if (query) {
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *profiler.queryPool, *query + 1);
+  }
+}
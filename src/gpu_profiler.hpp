@@ -0,0 +1,62 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "device.hpp"
+
+// Timestamp queries around named scopes of a frame's command buffer. Results are read back the next time the same
+// frame slot is recorded, after the pacer's timeline passed it, so reading never stalls. Every call is a no-op on
+// queues without timestamp support.
+class GpuProfiler {
+public:
+  static constexpr uint32_t MAX_SCOPES_PER_FRAME = 32;
+  static constexpr size_t HISTORY_LENGTH = 128;
+
+  // gpu milliseconds of the most recent frames, oldest first
+  using History = std::map<std::string, std::deque<double>>;
+
+  class Scope {
+    GpuProfiler &profiler;
+    const vk::raii::CommandBuffer &commandBuffer;
+    const std::optional<uint32_t> query;
+
+  public:
+    Scope(GpuProfiler &, const vk::raii::CommandBuffer &, const char *name);
+    ~Scope();
+  };
+
+private:
+  struct FrameQueries {
+    uint32_t firstQuery;
+    std::vector<const char *> scopes;
+  };
+
+  const double timestampPeriod;
+  const uint64_t timestampMask;
+  const vk::raii::QueryPool queryPool;
+
+  std::vector<FrameQueries> frames;
+  FrameQueries *recording = nullptr;
+  History scopeHistory;
+
+  std::optional<uint32_t> beginScope(const vk::raii::CommandBuffer &, const char *name);
+
+public:
+  GpuProfiler(const Device &, size_t frameCount);
+
+  [[nodiscard]] bool isSupported() const { return static_cast<bool>(*queryPool); }
+
+  // call once the pacer waited for the frame slot, before recording it again
+  void collect(size_t frameIndex);
+  // must be recorded outside of a render pass, before any scope of the frame
+  void begin(const vk::raii::CommandBuffer &, size_t frameIndex);
+
+  [[nodiscard]] const History &history() const { return scopeHistory; }
+  [[nodiscard]] double average(const std::string &scope) const;
+};
@@ -3,126 +3,747 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
 #include <chrono>
-#include <iostream>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
 #include <ranges>
+#include <tuple>
 
-Graphics::Graphics(const vkfw::Window &window)
-    : base(window),
-      device(base.instance, base.surface),
-      pipeline(device.details.format.format, device.handle),
-      frames(device.createFrames(pipeline.descriptorSetLayout)),
-      quadBuffers(device.handle, device.details.physicalDevice, quad),
-      swapchain(window, base.surface, device, pipeline.renderPass) {
-  window.callbacks()->on_framebuffer_resize = [&](const vkfw::Window &, size_t, size_t) { recreateSwapchain(window); };
-  quadBuffers.copyData(device.handle, device.commandPool, device.queue);
+#include "stopwatch.hpp"
+#include "trace.hpp"
+
+const std::array<Vertex, 4> QUAD_VERTICES = {{
+    {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
+    {{+0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
+    {{+0.5f, +0.5f}, {0.0f, 0.0f, 1.0f}},
+    {{-0.5f, +0.5f}, {1.0f, 1.0f, 1.0f}},
+}};
+const std::array<Index, 6> QUAD_INDICES = {0, 1, 2, 2, 3, 0};
+
+vk::Extent2D framebufferExtent(const vkfw::Window &window) {
+  auto [width, height] = static_cast<std::tuple<uint32_t, uint32_t>>(window.getFramebufferSize());
+  return {width, height};
+}
+
+FrameSnapshot animate(double seconds) {
+  auto angle = static_cast<float>(seconds) * glm::radians(90.0f);
+  return {
+      .model = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f)),
+      .view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+  };
+}
+
+std::variant<Swapchain, Offscreen> createTarget(const vkfw::Window *window,
+                                               const vk::Extent2D &extent,
+                                               const Base &base,
+                                               const Device &device,
+                                               const Pipeline &pipeline,
+                                               const Settings &settings) {
+  if (window) {
+    return std::variant<Swapchain, Offscreen>(
+        std::in_place_type<Swapchain>, extent, base.surface, device, pipeline.renderPass, settings.present);
+  } else {
+    return std::variant<Swapchain, Offscreen>(
+        std::in_place_type<Offscreen>, device, pipeline.renderPass, extent, settings.framesInFlight);
+  }
+}
+
+DrawableBuffers createMeshBuffers(const Device &device,
+                                  Uploader &uploader,
+                                  const Settings &settings,
+                                  std::optional<MeshOptimizerReport> &optimization) {
+  TRACE_SCOPE("createMeshBuffers");
+  if (settings.meshPath.empty()) {
+    return DrawableBuffers(
+        device.handle, device.allocator, uploader, QUAD_VERTICES, QUAD_INDICES, settings.vertexFormat);
+  }
+  // the mapping only has to live until the data is in staging memory
+  MeshFile mesh(settings.meshPath);
+  if (settings.optimizeMesh) {
+    auto data = readMeshData(mesh);
+    optimization = optimizeMesh(data);
+    return DrawableBuffers(device.handle, device.allocator, uploader, data, settings.vertexFormat);
+  }
+  return DrawableBuffers(device.handle, device.allocator, uploader, mesh, settings.vertexFormat);
+}
+
+// settings that would size buffers or descriptor ranges to zero are rejected before anything is created
+const Settings &validateSettings(const Settings &settings) {
+  if (settings.objectCount == 0) {
+    throw std::runtime_error("At least one object is required");
+  }
+  return settings;
+}
+
+vk::DeviceSize uniformSliceSize(const Settings &settings, const Device &device) {
+  auto alignment = device.details.properties.limits.minUniformBufferOffsetAlignment;
+  // only the default path has a ubo per object, the others share a single one
+  auto uboCount = settings.instanced || settings.gpuCulling || settings.pushConstants ? 1 : settings.objectCount;
+  return uboCount * alignUp(sizeof(UniformBufferObject), alignment);
+}
+
+vk::DeviceSize instanceSliceSize(const Settings &settings) {
+  return (settings.instanced ? settings.objectCount : 1) * sizeof(InstanceData);
+}
+
+// lays objects out on a square grid filling the [-1, 1] range
+glm::mat4 gridTransform(size_t index, size_t count) {
+  auto side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+  float spacing = 2.0f / side;
+  auto position = glm::vec3(-1.0f + spacing * (index % side + 0.5f), -1.0f + spacing * (index / side + 0.5f), 0.0f);
+  return glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(spacing));
+}
+
+// objects on a grid, the per-frame spin is applied as the scene's model matrix
+Scene createScene(const Settings &settings, const glm::vec4 &meshBounds, ThreadPool &workers) {
+  Scene scene;
+  for (size_t i = 0; i < settings.objectCount; i++) {
+    scene.add(settings.objectCount == 1 ? glm::mat4(1.0f) : gridTransform(i, settings.objectCount),
+              glm::vec4(1.0f),
+              meshBounds);
+  }
+  scene.update(workers);
+  return scene;
+}
+
+// object data is static on the gpu culling path, the per-frame spin comes with the ubo's model matrix
+std::optional<GpuCulling> createCulling(const Device &device,
+                                        const Pipeline &pipeline,
+                                        Uploader &uploader,
+                                        DescriptorAllocator &descriptors,
+                                        const Buffer &uniformBuffer,
+                                        const Scene &scene,
+                                        const Settings &settings) {
+  if (!settings.gpuCulling) {
+    return std::nullopt;
+  }
+  if (!device.details.indirectCount) {
+    throw std::runtime_error("GPU culling needs multiDrawIndirect, drawIndirectFirstInstance and drawIndirectCount");
+  }
+  TRACE_SCOPE("createCulling");
+  std::vector<InstanceData> objects(scene.size());
+  for (uint32_t i = 0; i < objects.size(); i++) {
+    objects[i] = {
+        .transform = scene.transform(i),
+        .color = scene.color(i),
+    };
+  }
+  return std::optional<GpuCulling>(
+      std::in_place, device, pipeline, uploader, descriptors, uniformBuffer, objects, settings.framesInFlight);
+}
+
+std::optional<PresentFences> createPresentFences(const Device &device) {
+  if (!device.details.presentFences) {
+    return std::nullopt;
+  }
+  return std::optional<PresentFences>(std::in_place, device.handle);
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start,
+                         std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now()) {
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// times the construction of a member, guaranteed copy elision still constructs the result in place
+template <typename F>
+auto timePhase(StartupTimings &startup, const char *name, F &&construct) {
+  struct Record {
+    StartupTimings &startup;
+    const char *name;
+    Stopwatch stopwatch;
+
+    ~Record() { startup.phases.emplace_back(name, stopwatch.lap()); }
+  } record{startup, name};
+  return construct();
+}
+
+Graphics::Graphics(const vkfw::Window *window, const vk::Extent2D &extent, const Settings &settings)
+    : settings(validateSettings(settings)),
+      base(timePhase(startup, "instance", [&] { return Base(window); })),
+      device(timePhase(startup, "device", [&] { return Device(base); })),
+      pipelineCache(timePhase(startup,
+                              "pipeline cache",
+                              [&] {
+                                return PipelineCache(
+                                    device.handle, device.details.properties, settings.pipelineCachePath);
+                              })),
+      pipeline(timePhase(startup,
+                         "pipeline submit",
+                         [&] {
+                           return Pipeline(device.details.format.format,
+                                           window ? vk::ImageLayout::ePresentSrcKHR
+                                                  : vk::ImageLayout::eTransferSrcOptimal,
+                                           device.handle,
+                                           pipelineCache.handle,
+                                           settings.vertexFormat);
+                         })),
+      uploader(device.handle,
+               device.allocator,
+               device.transferQueue,
+               device.details.transferQueueFamilyIndex,
+               device.queue,
+               device.details.queueFamilyIndex),
+      profiler(device, settings.framesInFlight),
+      workers(settings.recordThreads > 1 ? settings.recordThreads : 0),
+      recorder(device.handle, device.details.queueFamilyIndex, settings.framesInFlight, workers.size()),
+      uniformRing(device.handle,
+                  device.allocator,
+                  vk::BufferUsageFlagBits::eUniformBuffer,
+                  device.details.properties.limits.minUniformBufferOffsetAlignment,
+                  uniformSliceSize(settings, device),
+                  settings.framesInFlight),
+      instanceRing(device.handle,
+                   device.allocator,
+                   vk::BufferUsageFlagBits::eVertexBuffer,
+                   alignof(InstanceData),
+                   instanceSliceSize(settings),
+                   settings.framesInFlight),
+      pacer(device.handle, settings.framesInFlight),
+      presentMonitor(device.handle, pacer.semaphore(), device.details.presentWait),
+      frames(device.createFrames(settings.framesInFlight)),
+      descriptors(device.handle, descriptorsPerSet({Pipeline::descriptorSetBindings}), settings.framesInFlight),
+      persistentDescriptors(
+          device.handle,
+          descriptorsPerSet({Pipeline::indirectDescriptorSetBindings, Pipeline::cullDescriptorSetBindings})),
+      meshBuffers(createMeshBuffers(device, uploader, settings, meshOptimization)),
+      scene(createScene(settings, meshBuffers.bounds, workers)),
+      culling(createCulling(device, pipeline, uploader, persistentDescriptors, uniformRing, scene, settings)),
+      target(timePhase(startup,
+                       "render target",
+                       [&] { return createTarget(window, extent, base, device, pipeline, settings); })),
+      presentFences(createPresentFences(device)),
+      framebufferSize(extent) {
+  uploader.flush();
+  // only the variant the settings draw with is needed for the first frame, the others keep compiling
+  timePhase(startup,
+            "critical pipeline",
+            [&] {
+              if (settings.gpuCulling) {
+                pipeline.cull.wait();
+                pipeline.indirect.wait();
+              } else {
+                (settings.instanced       ? pipeline.instanced
+                 : settings.pushConstants ? pipeline.pushConstant
+                                          : pipeline.handle)
+                    .wait();
+              }
+            });
+  startup.total = millisecondsSince(created);
+  startup.warmPipelineCache = pipelineCache.warm();
 }
 
-void Graphics::recordCommandBuffer(const vk::raii::CommandBuffer &commandBuffer, size_t framebufferIndex) const {
+Graphics::Graphics(const vkfw::Window &window, const Settings &settings)
+    : Graphics(&window, framebufferExtent(window), settings) {}
+
+Graphics::Graphics(const vk::Extent2D &extent, const Settings &settings) : Graphics(nullptr, extent, settings) {}
+
+vk::Extent2D Graphics::extent() const {
+  return std::visit([](const auto &target) { return target.extent; }, target);
+}
+
+void Graphics::recordCommandBuffer(const vk::raii::CommandBuffer &commandBuffer,
+                                   const vk::raii::Framebuffer &framebuffer) {
+  TRACE_SCOPE("Graphics::recordCommandBuffer");
+  auto extent = this->extent();
   std::array<vk::ClearValue, 1> clearValues = {{{{{{0.0f, 0.0f, 0.0f, 1.0f}}}}}};
   std::array<vk::Viewport, 1> viewports = {vk::Viewport{
       .x = 0.0f,
       .y = 0.0f,
-      .width = static_cast<float>(swapchain.extent.width),
-      .height = static_cast<float>(swapchain.extent.height),
+      .width = static_cast<float>(extent.width),
+      .height = static_cast<float>(extent.height),
       .minDepth = 0.0f,
       .maxDepth = 1.0f,
   }};
   std::array<vk::Rect2D, 1> scissors = {vk::Rect2D{
       .offset = {0, 0},
-      .extent = swapchain.extent,
+      .extent = extent,
   }};
 
   commandBuffer.begin({});
-  commandBuffer.beginRenderPass(
-      vk::RenderPassBeginInfo{
-          .renderPass = *pipeline.renderPass,
-          .framebuffer = *swapchain.framebuffers[framebufferIndex],
-          .renderArea =
-              {
-                  .offset = {0, 0},
-                  .extent = swapchain.extent,
-              },
+  profiler.begin(commandBuffer, pacer.frameIndex());
+  bool drawable = uploader.isComplete(meshBuffers.ticket) && (!culling || uploader.isComplete(culling->ticket));
+  if (culling && drawable) {
+    // fills the frame's indirect commands, compute can't be recorded inside the render pass
+    GpuProfiler::Scope cullScope(profiler, commandBuffer, "cull");
+    culling->cull(commandBuffer, pipeline, pacer.frameIndex(), cullConstants);
+  }
+  {
+    GpuProfiler::Scope renderPassScope(profiler, commandBuffer, "render pass");
+    // the instanced and gpu culling paths are a single draw, nothing to spread across threads
+    bool parallel = workers.size() > 0 && !settings.instanced && !culling && drawable;
+    auto secondaries = parallel ? recordSecondaries(framebuffer, viewports[0], scissors[0])
+                                : std::vector<vk::CommandBuffer>{};
+    commandBuffer.beginRenderPass(
+        vk::RenderPassBeginInfo{
+            .renderPass = *pipeline.renderPass,
+            .framebuffer = *framebuffer,
+            .renderArea =
+                {
+                    .offset = {0, 0},
+                    .extent = extent,
+                },
+        }
+            .setClearValues(clearValues),
+        parallel ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline);
+    if (parallel) {
+      // timestamps can't be written inside a subpass recorded from secondaries, only the render pass scope applies
+      if (!secondaries.empty()) {
+        commandBuffer.executeCommands(secondaries);
+      }
+    } else {
+      commandBuffer.setViewport(0, viewports);
+      commandBuffer.setScissor(0, scissors);
+      // keep presenting while geometry is still in flight
+      if (drawable && culling) {
+        GpuProfiler::Scope drawScope(profiler, commandBuffer, "indirect meshes");
+        culling->draw(commandBuffer, pipeline, meshBuffers, pacer.frameIndex(), uboOffsets[0]);
+      } else if (drawable && settings.instanced) {
+        GpuProfiler::Scope drawScope(profiler, commandBuffer, "instanced meshes");
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.instanced.get());
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+                                         *pipeline.pipelineLayout,
+                                         0,
+                                         {frameSet},
+                                         {uboOffsets[0]});
+        meshBuffers.drawInstanced(
+            commandBuffer, instanceRing.buffer, instanceOffset, static_cast<uint32_t>(visibleObjects.size()));
+      } else if (drawable) {
+        GpuProfiler::Scope drawScope(profiler, commandBuffer, "meshes");
+        recordDraws(commandBuffer, 0, visibleObjects.size());
       }
-          .setClearValues(clearValues),
-      vk::SubpassContents::eInline);
-  commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.handle);
-  commandBuffer.bindVertexBuffers(0, {*quadBuffers.vertexBuffer.deviceBuffer.buffer}, {0});
-  commandBuffer.bindIndexBuffer(*quadBuffers.indexBuffer.deviceBuffer.buffer, 0, vk::IndexType::eUint16);
-  commandBuffer.bindDescriptorSets(
-      vk::PipelineBindPoint::eGraphics, *pipeline.pipelineLayout, 0, {*frames[currentFrameIndex].descriptorSet}, {});
-  commandBuffer.setViewport(0, viewports);
-  commandBuffer.setScissor(0, scissors);
-  commandBuffer.drawIndexed(quad.indices.size(), 1, 0, 0, 0);
-  commandBuffer.endRenderPass();
+    }
+    commandBuffer.endRenderPass();
+  }
   commandBuffer.end();
 }
 
-void Graphics::recreateSwapchain(const vkfw::Window &window) {
-  waitIdle();
-  swapchain = Swapchain(window, base.surface, device, pipeline.renderPass, *swapchain.handle);
+std::vector<vk::CommandBuffer> Graphics::recordSecondaries(const vk::raii::Framebuffer &framebuffer,
+                                                          const vk::Viewport &viewport,
+                                                          const vk::Rect2D &scissor) {
+  TRACE_SCOPE("Graphics::recordSecondaries");
+  // the pacer saw the timeline reach this frame slot's last value, so none of its secondaries are still executing
+  recorder.reset(pacer.frameIndex());
+
+  auto inheritanceInfo = vk::CommandBufferInheritanceInfo{
+      .renderPass = *pipeline.renderPass,
+      .subpass = 0,
+      .framebuffer = *framebuffer,
+  };
+  auto partitionCount = std::min(recorder.threadCount(), visibleObjects.size());
+  std::vector<vk::CommandBuffer> result;
+  std::vector<std::future<void>> recorded;
+  for (size_t i = 0; i < partitionCount; i++) {
+    auto begin = visibleObjects.size() * i / partitionCount;
+    auto end = visibleObjects.size() * (i + 1) / partitionCount;
+    const auto &commandBuffer = recorder.commandBuffer(pacer.frameIndex(), i);
+    result.push_back(*commandBuffer);
+    recorded.push_back(workers.submit([this, &inheritanceInfo, &commandBuffer, &viewport, &scissor, begin, end] {
+      TRACE_SCOPE("Graphics::recordSecondary");
+      commandBuffer.begin({
+          .flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue |
+                   vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+          .pInheritanceInfo = &inheritanceInfo,
+      });
+      // dynamic state is not inherited from the primary
+      commandBuffer.setViewport(0, viewport);
+      commandBuffer.setScissor(0, scissor);
+      recordDraws(commandBuffer, begin, end);
+      commandBuffer.end();
+    }));
+  }
+
+  // every task borrows locals, let all of them finish before an exception unwinds the stack
+  for (auto &future : recorded) {
+    future.wait();
+  }
+  for (auto &future : recorded) {
+    future.get();
+  }
+  return result;
 }
 
-void Graphics::updateUbo() {
-  static auto start = std::chrono::high_resolution_clock::now();
-  auto current = std::chrono::high_resolution_clock::now();
-  float delta = std::chrono::duration<float, std::chrono::seconds::period>(current - start).count();
-  float aspectRatio = (float)swapchain.extent.width / (float)swapchain.extent.height;
+void Graphics::recordDraws(const vk::raii::CommandBuffer &commandBuffer, size_t begin, size_t end) const {
+  if (settings.pushConstants) {
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.pushConstant.get());
+    meshBuffers.bind(commandBuffer);
+    // one bind for the whole range, only the push constants change between draws
+    commandBuffer.bindDescriptorSets(
+        vk::PipelineBindPoint::eGraphics, *pipeline.pipelineLayout, 0, {frameSet}, {uboOffsets[0]});
+    for (auto i = begin; i < end; i++) {
+      commandBuffer.pushConstants<ObjectPushConstants>(
+          *pipeline.pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, objectConstants[i]);
+      commandBuffer.drawIndexed(meshBuffers.indexCount, 1, 0, 0, 0);
+    }
+    return;
+  }
 
-  ubo.model = glm::rotate(glm::mat4(1.0f), delta * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-  ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.handle.get());
+  meshBuffers.bind(commandBuffer);
+  for (auto i = begin; i < end; i++) {
+    commandBuffer.bindDescriptorSets(
+        vk::PipelineBindPoint::eGraphics, *pipeline.pipelineLayout, 0, {frameSet}, {uboOffsets[i]});
+    commandBuffer.drawIndexed(meshBuffers.indexCount, 1, 0, 0, 0);
+  }
+}
+
+void Graphics::recreateSwapchain() {
+  TRACE_SCOPE("Graphics::recreateSwapchain");
+  Stopwatch stopwatch;
+  auto &swapchain = std::get<Swapchain>(target);
+  if (settings.recreateIdle) {
+    waitIdle();
+    swapchain =
+        Swapchain(framebufferSize, base.surface, device, pipeline.renderPass, settings.present, *swapchain.handle);
+  } else if (presentFences) {
+    // the images, views and framebuffers of the old swapchain go with it, frames already submitted may still render to
+    // them and the presentation engine may still hold them. Its presents' fences tell when both are done
+    Swapchain next(framebufferSize, base.surface, device, pipeline.renderPass, settings.present, *swapchain.handle);
+    retired.retire(std::move(swapchain), pacer.framesSubmitted());
+    swapchain = std::move(next);
+  } else {
+    // nothing reports when presentation let go of the old swapchain, a queue wait at least covers the frames rendering
+    // to it and the presents queued behind them
+    Swapchain next(framebufferSize, base.surface, device, pipeline.renderPass, settings.present, *swapchain.handle);
+    device.queue.waitIdle();
+    swapchain = std::move(next);
+  }
+  presentMonitor.swapchainRecreated();
+  swapchainRecreations++;
+  recreateMilliseconds += stopwatch.lap();
+}
+
+void Graphics::updateUbos(const FrameSnapshot &snapshot) {
+  TRACE_SCOPE("Graphics::updateUbos");
+  auto extent = this->extent();
+  float aspectRatio = (float)extent.width / (float)extent.height;
+
+  UniformBufferObject ubo;
+  const auto &rotation = snapshot.model;
+  ubo.view = snapshot.view;
   ubo.proj = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 10.0f);
   ubo.proj[1][1] *= -1;
+
+  uboOffsets.clear();
+  if (culling) {
+    ubo.model = rotation;
+    uboOffsets.push_back(uniformRing.push(ubo));
+
+    // the shader applies the spin before the object transform, so the bounds spin with it
+    const auto &bounds = meshBuffers.bounds;
+    cullConstants = {
+        .planes = frustumPlanes(ubo.proj * ubo.view),
+        .bounds = glm::vec4(glm::vec3(rotation * glm::vec4(glm::vec3(bounds), 1.0f)), bounds.w),
+        .objectCount = settings.objectCount,
+        .indexCount = meshBuffers.indexCount,
+    };
+    return;
+  }
+  scene.setModel(rotation);
+  scene.update(workers);
+  if (settings.cpuCulling) {
+    scene.cull(frustumPlanes(ubo.proj * ubo.view), visibleObjects);
+  } else {
+    visibleObjects.resize(scene.size());
+    std::iota(visibleObjects.begin(), visibleObjects.end(), 0);
+  }
+
+  if (settings.instanced) {
+    ubo.model = glm::mat4(1.0f);
+    uboOffsets.push_back(uniformRing.push(ubo));
+
+    auto [offset, instances] = instanceRing.allocate<InstanceData>(visibleObjects.size());
+    scene.writeTransforms(visibleObjects,
+                          reinterpret_cast<std::byte *>(instances.data()) + offsetof(InstanceData, transform),
+                          sizeof(InstanceData),
+                          workers);
+    for (size_t i = 0; i < instances.size(); i++) {
+      instances[i].color = scene.color(visibleObjects[i]);
+    }
+    instanceOffset = offset;
+    return;
+  }
+  if (settings.pushConstants) {
+    ubo.model = glm::mat4(1.0f);
+    uboOffsets.push_back(uniformRing.push(ubo));
+
+    // plain host memory, copied into the command buffer while recording
+    objectConstants.resize(visibleObjects.size());
+    scene.writeTransforms(visibleObjects,
+                          reinterpret_cast<std::byte *>(objectConstants.data()),
+                          sizeof(ObjectPushConstants),
+                          workers);
+    return;
+  }
+  // one aligned ubo per visible object, the model matrices are written into place by the scene
+  auto stride = alignUp(sizeof(UniformBufferObject), uniformRing.alignment);
+  auto [offset, slots] = uniformRing.allocate<std::byte>(stride * visibleObjects.size());
+  for (size_t i = 0; i < visibleObjects.size(); i++) {
+    auto *slot = reinterpret_cast<UniformBufferObject *>(slots.data() + i * stride);
+    slot->view = ubo.view;
+    slot->proj = ubo.proj;
+    uboOffsets.push_back(static_cast<uint32_t>(offset + i * stride));
+  }
+  scene.writeTransforms(visibleObjects, slots.data() + offsetof(UniformBufferObject, model), stride, workers);
+}
+
+void Graphics::writeFrameSet() {
+  frameSet = descriptors.allocate(pipeline.descriptorSetLayout);
+  auto bufferInfos = {vk::DescriptorBufferInfo{
+      .buffer = *uniformRing.buffer,
+      .offset = 0,
+      .range = sizeof(UniformBufferObject),
+  }};
+  device.handle.updateDescriptorSets(vk::WriteDescriptorSet{
+                                         .dstSet = frameSet,
+                                         .dstBinding = 0,
+                                         .dstArrayElement = 0,
+                                         .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
+                                     }
+                                         .setBufferInfo(bufferInfos),
+                                     {});
+}
+
+void Graphics::recordFrame(const Frame &frame,
+                           const vk::raii::Framebuffer &framebuffer,
+                           const FrameSnapshot &snapshot) {
+  TRACE_SCOPE("Graphics::recordFrame");
+  uploader.collect();
+  profiler.collect(pacer.frameIndex());
+  // presents are tagged with pacer values, a released present's frame also completed on the gpu
+  if (presentFences) {
+    retired.collect(presentFences->collect());
+  }
+
+  // the pacer guarantees the gpu is done reading this frame's slice
+  uniformRing.beginFrame(pacer.frameIndex());
+  instanceRing.beginFrame(pacer.frameIndex());
+  descriptors.beginFrame(pacer.frameIndex());
+  writeFrameSet();
+  updateUbos(snapshot);
+
+  frame.commandBuffer.reset();
+  recordCommandBuffer(frame.commandBuffer, framebuffer);
+}
+
+FrameSnapshot Graphics::animateSinceCreated() const {
+  return animate(std::chrono::duration<double>(std::chrono::steady_clock::now() - created).count());
 }
 
 void Graphics::draw(const vkfw::Window &window) {
+  // polled rather than hooked into the window's callbacks, which stay the caller's
+  auto size = framebufferExtent(window);
+  // minimized, no swapchain can be created until the window is restored
+  if (size.width == 0 || size.height == 0) {
+    return;
+  }
+  if (size != framebufferSize) {
+    resize(size);
+  }
+  drawToSwapchain(animateSinceCreated());
+}
 
-  const Frame &currentFrame = frames[currentFrameIndex];
-  updateUbo();
-  currentFrame.uniformBuffer.copyData(ubo);
+void Graphics::draw() {
+  drawOffscreen(animateSinceCreated());
+}
 
-  auto fenceResult = device.handle.waitForFences({*currentFrame.inFlight}, true, std::numeric_limits<uint64_t>::max());
-  if (fenceResult != vk::Result::eSuccess) {
-    throw std::runtime_error("Failed waiting for fence");
+void Graphics::draw(const FrameSnapshot &snapshot) {
+  if (std::holds_alternative<Swapchain>(target)) {
+    drawToSwapchain(snapshot);
+  } else {
+    drawOffscreen(snapshot);
   }
+}
+
+void Graphics::resize(const vk::Extent2D &framebufferSize) {
+  this->framebufferSize = framebufferSize;
+  recreateSwapchain();
+}
 
-  auto [acquireResult, imageIndex] =
-      swapchain.handle.acquireNextImage(std::numeric_limits<uint64_t>::max(), *currentFrame.imageAvailable);
+void Graphics::drawToSwapchain(const FrameSnapshot &snapshot) {
+  TRACE_SCOPE("Graphics::draw");
+  Stopwatch stopwatch;
+  timings = {};
 
-  if (acquireResult == vk::Result::eErrorOutOfDateKHR) {
-    std::cerr << "Image Out Of Date\n";
-    recreateSwapchain(window);
+  auto &swapchain = std::get<Swapchain>(target);
+  const Frame &currentFrame = frames[pacer.frameIndex()];
+  timings.gpuWait = pacer.waitForFrame();
+  presentMonitor.poll(swapchain.handle);
+  timings.latencyWait = presentMonitor.limit(swapchain.handle, settings.present.maxFrameLatency);
+  stopwatch.lap();
+
+  uint32_t imageIndex;
+  try {
+    auto [acquireResult, acquired] =
+        swapchain.handle.acquireNextImage(std::numeric_limits<uint64_t>::max(), *currentFrame.imageAvailable);
+    // a suboptimal swapchain still hands out images, it is recreated once the window reports its new size
+    if (acquireResult != vk::Result::eSuccess && acquireResult != vk::Result::eSuboptimalKHR) {
+      throw std::runtime_error("Failed acquire");
+    }
+    imageIndex = acquired;
+  } catch (const vk::OutOfDateKHRError &) {
+    // nothing was acquired, the frame is skipped
+    timings.acquire = stopwatch.lap();
+    recreateSwapchain();
+    timings.total = timings.gpuWait + timings.latencyWait + timings.acquire;
     return;
-  } else if (acquireResult != vk::Result::eSuccess && acquireResult != vk::Result::eSuboptimalKHR) {
-    throw std::runtime_error("Failed acquire");
   }
+  timings.acquire = stopwatch.lap();
 
-  // must occur after swapchain recreation, due to early return
-  device.handle.resetFences({*currentFrame.inFlight});
-
-  currentFrame.commandBuffer.reset();
-  recordCommandBuffer(currentFrame.commandBuffer, imageIndex);
+  recordFrame(currentFrame, swapchain.framebuffers[imageIndex], snapshot);
+  timings.record = stopwatch.lap();
 
   auto waitStages = {static_cast<vk::PipelineStageFlags>(vk::PipelineStageFlagBits::eColorAttachmentOutput)};
-  device.queue.submit(vk::SubmitInfo{}
+  auto signalSemaphores = {*currentFrame.renderFinished, *pacer.semaphore()};
+  // the value for the binary semaphore is ignored
+  auto signalValues = {uint64_t{0}, pacer.signalValue()};
+  auto timelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{}.setSignalSemaphoreValues(signalValues);
+  device.queue.submit(vk::SubmitInfo{.pNext = &timelineSubmitInfo}
                           .setWaitSemaphores(*currentFrame.imageAvailable)
                           .setWaitDstStageMask(waitStages)
                           .setCommandBuffers(*currentFrame.commandBuffer)
-                          .setSignalSemaphores(*currentFrame.renderFinished),
-                      *currentFrame.inFlight);
+                          .setSignalSemaphores(signalSemaphores));
+  pacer.advance();
+  presentMonitor.submitted(pacer.framesSubmitted());
+  timings.submit = stopwatch.lap();
+  if (pacer.framesSubmitted() == 1) {
+    startup.firstFrame = millisecondsSince(created);
+  }
 
   auto swapchains = {*swapchain.handle};
   auto imageIndices = {imageIndex};
-  auto presentResult = device.queue.presentKHR(vk::PresentInfoKHR{}
-                                                   .setWaitSemaphores(*currentFrame.renderFinished)
-                                                   .setSwapchains(swapchains)
-                                                   .setImageIndices(imageIndices));
-  if (presentResult == vk::Result::eErrorOutOfDateKHR) {
-    std::cerr << "Image Out Of Date\n";
-    recreateSwapchain(window);
-  } else if (presentResult != vk::Result::eSuccess && presentResult != vk::Result::eSuboptimalKHR) {
-    throw std::runtime_error("Failed presentation");
-  }
-
-  currentFrameIndex = currentFrameIndex ^ 1;
+  // the frame's pacer value, what PresentMonitor waits for
+  auto presentIds = {pacer.framesSubmitted()};
+  auto presentId = vk::PresentIdKHR{}.setPresentIds(presentIds);
+  auto presentFence = presentFences ? *presentFences->next() : vk::Fence{};
+  auto presentFenceInfo = vk::SwapchainPresentFenceInfoEXT{}.setFences(presentFence);
+  auto presentInfo = vk::PresentInfoKHR{}
+                         .setWaitSemaphores(*currentFrame.renderFinished)
+                         .setSwapchains(swapchains)
+                         .setImageIndices(imageIndices);
+  if (presentFences) {
+    presentFenceInfo.pNext = presentInfo.pNext;
+    presentInfo.pNext = &presentFenceInfo;
+  }
+  if (device.details.presentWait) {
+    presentId.pNext = presentInfo.pNext;
+    presentInfo.pNext = &presentId;
+  }
+  try {
+    auto presentResult = device.queue.presentKHR(presentInfo);
+    if (presentFences) {
+      presentFences->queued(pacer.framesSubmitted());
+    }
+    timings.present = stopwatch.lap();
+    if (presentResult != vk::Result::eSuccess && presentResult != vk::Result::eSuboptimalKHR) {
+      throw std::runtime_error("Failed presentation");
+    }
+  } catch (const vk::OutOfDateKHRError &) {
+    // still counts as queued, the present's semaphore wait and fence go ahead as usual
+    if (presentFences) {
+      presentFences->queued(pacer.framesSubmitted());
+    }
+    timings.present = stopwatch.lap();
+    recreateSwapchain();
+  }
+
+  timings.total =
+      timings.gpuWait + timings.latencyWait + timings.acquire + timings.record + timings.submit + timings.present;
+}
+
+void Graphics::drawOffscreen(const FrameSnapshot &snapshot) {
+  TRACE_SCOPE("Graphics::draw headless");
+  Stopwatch stopwatch;
+  timings = {};
+
+  auto frameIndex = pacer.frameIndex();
+  const Frame &currentFrame = frames[frameIndex];
+  timings.gpuWait = pacer.waitForFrame();
+  stopwatch.lap();
+
+  // each frame in flight owns the offscreen image of the same index
+  recordFrame(currentFrame, std::get<Offscreen>(target).framebuffers[frameIndex], snapshot);
+  timings.record = stopwatch.lap();
+
+  auto signalValues = {pacer.signalValue()};
+  auto timelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{}.setSignalSemaphoreValues(signalValues);
+  device.queue.submit(vk::SubmitInfo{.pNext = &timelineSubmitInfo}
+                          .setCommandBuffers(*currentFrame.commandBuffer)
+                          .setSignalSemaphores(*pacer.semaphore()));
+  pacer.advance();
+  timings.submit = stopwatch.lap();
+  if (pacer.framesSubmitted() == 1) {
+    startup.firstFrame = millisecondsSince(created);
+  }
+
+  timings.total = timings.gpuWait + timings.record + timings.submit;
+}
+
+StartupTimings Graphics::startupTimings() const {
+  auto result = startup;
+  for (const auto &timing : pipeline.compiler.timings()) {
+    result.pipelines.push_back({
+        .name = timing.name,
+        .start = millisecondsSince(created, timing.start),
+        .end = millisecondsSince(created, timing.end),
+    });
+  }
+  return result;
+}
+
+void Graphics::report(std::ostream &out) const {
+  auto startupReport = startupTimings();
+  out << "startup: " << startupReport.total << " ms, pipeline cache "
+      << (startupReport.warmPipelineCache ? "warm" : "cold") << "\n";
+  for (const auto &[phase, milliseconds] : startupReport.phases) {
+    out << "  " << phase << ": " << milliseconds << " ms\n";
+  }
+  out << "  first frame submitted at " << startupReport.firstFrame << " ms\n";
+  for (const auto &[name, start, end] : startupReport.pipelines) {
+    out << "  pipeline " << name << " compiled from " << start << " to " << end << " ms\n";
+  }
+  out << device.allocator.stats() << "staging bytes in flight: " << uploader.stagingBytes() << "\n";
+  if (uploader.transfersOwnership()) {
+    out << "uploads: dedicated transfer queue family " << device.details.transferQueueFamilyIndex << "\n";
+  } else {
+    out << "uploads: graphics queue\n";
+  }
+  out << "vertices: " << vertexFormatInfo(settings.vertexFormat).name << ", " << meshBuffers.vertexBuffer.size
+      << " bytes\n";
+  if (culling) {
+    out << "gpu culling: " << settings.objectCount << " objects, one indirect count draw\n";
+  }
+  if (settings.cpuCulling && !culling) {
+    out << "cpu culling: " << cullKernelName(bestCullKernel()) << " kernel, " << visibleObjects.size() << " of "
+        << scene.size() << " objects visible in the last frame\n";
+  }
+  if (meshOptimization) {
+    out << "mesh optimization: " << meshOptimization->verticesBefore << " -> " << meshOptimization->verticesAfter
+        << " vertices, acmr " << meshOptimization->before.acmr << " -> " << meshOptimization->after.acmr << ", atvr "
+        << meshOptimization->before.atvr << " -> " << meshOptimization->after.atvr << "\n";
+  }
+  if (const auto *swapchain = std::get_if<Swapchain>(&target)) {
+    out << "present: " << presentModeName(swapchain->presentMode) << ", " << swapchain->images.size()
+        << " swapchain images, latency target " << settings.present.maxFrameLatency << ", "
+        << presentMonitor.metricName() << (presentMonitor.usesPresentWait() ? " " : " (no present wait) ")
+        << presentMonitor.average() << " ms\n";
+  }
+  if (swapchainRecreations > 0) {
+    out << "swapchain recreated " << swapchainRecreations << " times, " << recreateMilliseconds / swapchainRecreations
+        << " ms each, " << retired.destroyedCount() << " retired resources destroyed, " << retired.pending()
+        << " pending\n";
+  }
+  out << "descriptor pools: " << descriptors.poolCount() << ", sets allocated per frame: "
+      << descriptors.setsLastFrame() << "\n";
+  auto frameCount = std::max<uint64_t>(pacer.framesSubmitted(), 1);
+  out << "frames in flight: " << pacer.frameCount() << ", cpu blocked on gpu: " << pacer.blockedMilliseconds()
+      << " ms over " << pacer.framesSubmitted() << " frames (" << pacer.blockedMilliseconds() / frameCount
+      << " ms per frame)\n";
+  if (!profiler.isSupported()) {
+    out << "gpu timestamps not supported\n";
+  }
+  for (const auto &[scope, _] : profiler.history()) {
+    out << "gpu " << scope << ": " << profiler.average(scope) << " ms\n";
+  }
 }
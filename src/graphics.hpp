@@ -1,51 +1,216 @@
 #pragma once
 
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <utility>
+#include <variant>
 #include <vector>
 
+#include <glm/glm.hpp>
 #include <vkfw/vkfw.hpp>
 #include <vulkan/vulkan_raii.hpp>
 
 #include "base.hpp"
 #include "buffer.hpp"
+#include "deletion_queue.hpp"
+#include "descriptor_allocator.hpp"
 #include "device.hpp"
 #include "drawable.hpp"
 #include "frame.hpp"
+#include "frame_pacer.hpp"
+#include "gpu_culling.hpp"
+#include "gpu_profiler.hpp"
+#include "mesh_optimizer.hpp"
+#include "offscreen.hpp"
+#include "parallel_recorder.hpp"
 #include "pipeline.hpp"
+#include "pipeline_cache.hpp"
+#include "present_fences.hpp"
+#include "present_monitor.hpp"
+#include "ring_buffer.hpp"
+#include "scene.hpp"
 #include "swapchain.hpp"
+#include "thread_pool.hpp"
+#include "uploader.hpp"
+
+struct Settings {
+  // meshes drawn per frame, laid out in a grid, at least one
+  uint32_t objectCount = 1;
+  // mesh file drawn for every object, a quad when empty
+  std::filesystem::path meshPath;
+  // layout vertices are quantized to on upload, packed formats trade precision for bandwidth
+  VertexFormat vertexFormat = VertexFormat::eFloat;
+  // dedupes and reorders the mesh file's vertices and indices before upload, the file has to store float vertices
+  bool optimizeMesh = false;
+  // draw every object with a single instanced call instead of one draw per object
+  bool instanced = false;
+  // one draw per object with its transform in push constants, instead of a ubo and a descriptor bind per object
+  bool pushConstants = false;
+  // cull on the gpu with a compute pass and draw the survivors with one indirect count call, takes over from instanced
+  bool gpuCulling = false;
+  // frustum culls objects on the cpu so only visible ones are recorded, the gpu culling path does its own
+  bool cpuCulling = true;
+  // threads recording the per-object draws into secondary command buffers, 1 records inline on the calling thread
+  uint32_t recordThreads = 1;
+  // more frames in flight trade latency for throughput
+  uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+  // present mode, swapchain image count and latency target, unused headless
+  PresentPolicy present;
+  // recreates the swapchain after waiting for the device to go idle and destroys the old one on the spot, instead of
+  // retiring it until its present fences signalled. The slower path, kept to compare resize storms against
+  bool recreateIdle = false;
+  // an empty path keeps the pipeline cache in memory only, a file is written on shutdown only when one is named
+  std::filesystem::path pipelineCachePath;
+};
+
+// What the simulation hands the renderer for one frame. A copy, so a renderer on another thread never reads state the
+// simulation is still changing.
+struct FrameSnapshot {
+  // applied to every object before its own transform
+  glm::mat4 model;
+  glm::mat4 view;
+};
+
+// the demo's spin around z, seconds since the simulation started
+FrameSnapshot animate(double seconds);
+
+// cpu time spent in each phase of a draw, in milliseconds
+struct FrameTimings {
+  // blocked until the gpu released the frame slot
+  double gpuWait;
+  // blocked for PresentPolicy::maxFrameLatency, 0 without a limit
+  double latencyWait;
+  double acquire;
+  double record;
+  double submit;
+  double present;
+  double total;
+};
+
+// wall clock milliseconds spent constructing the renderer
+struct StartupTimings {
+  struct Span {
+    std::string name;
+    double start;
+    double end;
+  };
+
+  // in construction order
+  std::vector<std::pair<std::string, double>> phases;
+  double total = 0.0;
+  bool warmPipelineCache = false;
+  // the remaining spans are relative to the start of construction, 0 until the first frame was submitted
+  double firstFrame = 0.0;
+  // compiled on worker threads, overlapping the phases and possibly the first frames
+  std::vector<Span> pipelines;
+};
 
 class Graphics {
+  using RenderTarget = std::variant<Swapchain, Offscreen>;
+
+  const std::chrono::steady_clock::time_point created = std::chrono::steady_clock::now();
+  StartupTimings startup;
+
+  const Settings settings;
   const Base base;
   const Device device;
+  const PipelineCache pipelineCache;
   const Pipeline pipeline;
+  Uploader uploader;
+  GpuProfiler profiler;
+  ThreadPool workers;
+  const ParallelRecorder recorder;
 
-  size_t currentFrameIndex = 0;
-  const std::array<Frame, 2> frames;
-
-  const Drawable quad = {
-      .vertices =
-          {
-              {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
-              {{+0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
-              {{+0.5f, +0.5f}, {0.0f, 0.0f, 1.0f}},
-              {{-0.5f, +0.5f}, {1.0f, 1.0f, 1.0f}},
-          },
-      .indices = {0, 1, 2, 2, 3, 0},
-  };
-  const DrawableBuffers quadBuffers;
+  RingBuffer uniformRing;
+  RingBuffer instanceRing;
+
+  FramePacer pacer;
+  PresentMonitor presentMonitor;
+  const std::vector<Frame> frames;
+  FrameDescriptorAllocator descriptors;
+  // sets written once and kept for the renderer's lifetime, never reset
+  DescriptorAllocator persistentDescriptors;
+  // allocated and written at the start of each frame, the ubo slices are selected with dynamic offsets
+  vk::DescriptorSet frameSet;
+
+  // filled in while meshBuffers is created, when Settings::optimizeMesh is set
+  std::optional<MeshOptimizerReport> meshOptimization;
+  const DrawableBuffers meshBuffers;
+  // every object drawn, bounded by the mesh's bounding sphere
+  Scene scene;
+  // empty unless Settings::gpuCulling is set
+  const std::optional<GpuCulling> culling;
 
-  UniformBufferObject ubo{};
+  // indices into scene recorded this frame
+  std::vector<uint32_t> visibleObjects;
+  std::vector<uint32_t> uboOffsets;
+  // parallel to visibleObjects on the push constant path
+  std::vector<ObjectPushConstants> objectConstants;
+  uint32_t instanceOffset = 0;
+  CullPushConstants cullConstants{};
+  FrameTimings timings{};
 
-  Swapchain swapchain;
+  RenderTarget target;
+  // swapchains replaced by recreateSwapchain, until the presentation engine released them
+  DeletionQueue retired;
+  // empty without Device::Details::presentFences, declared after retired so pending presents are waited for first
+  std::optional<PresentFences> presentFences;
+  size_t swapchainRecreations = 0;
+  double recreateMilliseconds = 0.0;
+  // the window's, kept here so swapchains can be recreated without touching the window off the main thread
+  vk::Extent2D framebufferSize;
 
-  void recordCommandBuffer(const vk::raii::CommandBuffer &, size_t) const;
-  void recreateSwapchain(const vkfw::Window &);
+  // a null window renders headless into offscreen images of the given extent
+  Graphics(const vkfw::Window *, const vk::Extent2D &, const Settings &);
+
+  [[nodiscard]] vk::Extent2D extent() const;
+
+  void recordFrame(const Frame &, const vk::raii::Framebuffer &, const FrameSnapshot &);
+  void recordCommandBuffer(const vk::raii::CommandBuffer &, const vk::raii::Framebuffer &);
+  // records one secondary command buffer per thread, each drawing a contiguous range of the objects
+  std::vector<vk::CommandBuffer> recordSecondaries(const vk::raii::Framebuffer &,
+                                                   const vk::Viewport &,
+                                                   const vk::Rect2D &scissor);
+  // draws visibleObjects[begin, end)
+  void recordDraws(const vk::raii::CommandBuffer &, size_t begin, size_t end) const;
+  // keeps rendering the frames in flight and retires the old swapchain until its presents were released. Without
+  // present fences nothing reports that, the graphics queue is waited for before the old swapchain is destroyed
+  void recreateSwapchain();
   void waitIdle() const { device.handle.waitIdle(); };
 
-  void updateUbo();
+  void drawToSwapchain(const FrameSnapshot &);
+  void drawOffscreen(const FrameSnapshot &);
+  [[nodiscard]] FrameSnapshot animateSinceCreated() const;
+
+  void updateUbos(const FrameSnapshot &);
+  void writeFrameSet();
 
 public:
-  Graphics(const vkfw::Window &window);
+  Graphics(const vkfw::Window &window, const Settings & = {});
+  Graphics(const vk::Extent2D &extent, const Settings & = {});
   ~Graphics() { waitIdle(); };
 
+  // draws the demo animation, recreates the swapchain first when the window's framebuffer size changed. Nothing is
+  // drawn while the framebuffer is zero sized
   void draw(const vkfw::Window &);
+  // headless counterpart to draw, nothing is presented so frames run as fast as the gpu allows
+  void draw();
+  // draws a snapshot to the window or headless, never touches the window so it can run on a render thread of its own
+  void draw(const FrameSnapshot &);
+  // recreates the swapchain for a framebuffer resized by the window system, on the thread that draws
+  void resize(const vk::Extent2D &framebufferSize);
+
+  [[nodiscard]] const FrameTimings &lastFrameTimings() const { return timings; }
+  [[nodiscard]] const GpuProfiler &gpuProfiler() const { return profiler; }
+  [[nodiscard]] const PresentMonitor &presentLatency() const { return presentMonitor; }
+  [[nodiscard]] const DrawableBuffers &mesh() const { return meshBuffers; }
+  [[nodiscard]] StartupTimings startupTimings() const;
+  // blocks until every pipeline variant has been compiled, the renderer only waits for the ones it draws with
+  void waitForPipelines() const { pipeline.compiler.waitIdle(); }
+
+  void report(std::ostream &) const;
 };
@@ -0,0 +1,93 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+  file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                     nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    file = nullptr;
+    throw std::runtime_error("Failed opening " + path.string());
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    throw std::runtime_error("Failed reading the size of " + path.string());
+  }
+  if (size.QuadPart == 0) {
+    return;
+  }
+
+  mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  auto view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!view) {
+    if (mapping) {
+      CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    throw std::runtime_error("Failed mapping " + path.string());
+  }
+  contents = {static_cast<const std::byte *>(view), static_cast<size_t>(size.QuadPart)};
+}
+
+MappedFile::~MappedFile() {
+  if (!contents.empty()) {
+    UnmapViewOfFile(contents.data());
+  }
+  if (mapping) {
+    CloseHandle(mapping);
+  }
+  if (file) {
+    CloseHandle(file);
+  }
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+  int descriptor = open(path.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    throw std::runtime_error("Failed opening " + path.string());
+  }
+  struct stat status {};
+  if (fstat(descriptor, &status) != 0) {
+    close(descriptor);
+    throw std::runtime_error("Failed reading the size of " + path.string());
+  }
+  if (status.st_size == 0) {
+    close(descriptor);
+    return;
+  }
+
+  auto size = static_cast<size_t>(status.st_size);
+  auto view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  // the mapping keeps the file alive on its own
+  close(descriptor);
+  if (view == MAP_FAILED) {
+    throw std::runtime_error("Failed mapping " + path.string());
+  }
+  // loaders read front to back
+  madvise(view, size, MADV_SEQUENTIAL);
+  contents = {static_cast<const std::byte *>(view), size};
+}
+
+MappedFile::~MappedFile() {
+  if (!contents.empty()) {
+    munmap(const_cast<std::byte *>(contents.data()), contents.size());
+  }
+}
+
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// Read-only memory mapping of a whole file, pages are faulted in by the os as they are touched.
+class MappedFile {
+  std::span<const std::byte> contents;
+#ifdef _WIN32
+  void *file = nullptr;
+  void *mapping = nullptr;
+#endif
+
+public:
+  explicit MappedFile(const std::filesystem::path &);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  [[nodiscard]] std::span<const std::byte> bytes() const { return contents; }
+};
@@ -0,0 +1,157 @@
+#include "mesh_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include "trace.hpp"
+
+const uint64_t BLOCK_ALIGNMENT = 16;
+
+uint64_t alignBlock(uint64_t offset) {
+  return (offset + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+}
+
+// whether count elements of the given size starting at offset lie within the file, without overflowing
+bool fits(std::span<const std::byte> bytes, uint64_t offset, uint64_t count, uint64_t size) {
+  return offset <= bytes.size() && (size == 0 || count <= (bytes.size() - offset) / size);
+}
+
+MeshFileHeader readHeader(std::span<const std::byte> bytes) {
+  MeshFileHeader header;
+  if (bytes.size() < sizeof(header)) {
+    throw std::runtime_error("Mesh file too small");
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != MeshFileHeader::MAGIC || header.version != MeshFileHeader::VERSION) {
+    throw std::runtime_error("Not a mesh file");
+  }
+  if (header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t)) {
+    throw std::runtime_error("Unsupported mesh index size");
+  }
+  if (!fits(bytes, sizeof(header), header.attributeCount, sizeof(MeshFileAttribute)) ||
+      !fits(bytes, header.vertexOffset, header.vertexCount, header.vertexStride) ||
+      !fits(bytes, header.indexOffset, header.indexCount, header.indexSize)) {
+    throw std::runtime_error("Truncated mesh file");
+  }
+  return header;
+}
+
+std::vector<MeshFileAttribute> readAttributes(std::span<const std::byte> bytes, const MeshFileHeader &header) {
+  std::vector<MeshFileAttribute> attributes(header.attributeCount);
+  std::memcpy(attributes.data(), bytes.data() + sizeof(header), attributes.size() * sizeof(MeshFileAttribute));
+  return attributes;
+}
+
+template <typename I>
+uint64_t maxIndex(std::span<const std::byte> indices) {
+  uint64_t max = 0;
+  for (size_t offset = 0; offset < indices.size(); offset += sizeof(I)) {
+    // the index block of a damaged file need not be aligned
+    I index;
+    std::memcpy(&index, indices.data() + offset, sizeof(index));
+    max = std::max<uint64_t>(max, index);
+  }
+  return max;
+}
+
+// an index past the vertex block would make the gpu read outside of the vertex buffer
+std::span<const std::byte> checkIndices(std::span<const std::byte> indices, const MeshFileHeader &header) {
+  if (indices.empty()) {
+    return indices;
+  }
+  auto max = header.indexSize == sizeof(uint16_t) ? maxIndex<uint16_t>(indices) : maxIndex<uint32_t>(indices);
+  if (max >= header.vertexCount) {
+    throw std::runtime_error("Mesh index out of range");
+  }
+  return indices;
+}
+
+MeshFile::MeshFile(const std::filesystem::path &path)
+    : file(path),
+      header(readHeader(file.bytes())),
+      attributes(readAttributes(file.bytes(), header)),
+      vertices(file.bytes().subspan(header.vertexOffset, header.vertexCount * header.vertexStride)),
+      indices(checkIndices(file.bytes().subspan(header.indexOffset, header.indexCount * header.indexSize), header)) {}
+
+vk::IndexType MeshFile::indexType() const {
+  return header.indexSize == sizeof(uint16_t) ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+}
+
+bool MeshFile::hasLayout(uint32_t stride, std::span<const vk::VertexInputAttributeDescription> expected) const {
+  return header.vertexStride == stride && std::ranges::equal(attributes, expected, [](const auto &a, const auto &e) {
+           return a.location == e.location && a.format == static_cast<uint32_t>(e.format) && a.offset == e.offset;
+         });
+}
+
+std::optional<VertexFormat> MeshFile::vertexFormat() const {
+  for (auto format : {VertexFormat::eFloat, VertexFormat::eHalf, VertexFormat::eSnorm}) {
+    const auto &info = vertexFormatInfo(format);
+    if (hasLayout(info.bindingDescription.stride, info.attributeDescriptions)) {
+      return format;
+    }
+  }
+  return std::nullopt;
+}
+
+template <typename I>
+void writeIndices(std::ostream &out, std::span<const uint32_t> indices) {
+  for (auto index : indices) {
+    auto narrowed = static_cast<I>(index);
+    out.write(reinterpret_cast<const char *>(&narrowed), sizeof(narrowed));
+  }
+}
+
+void writePadding(std::ostream &out, uint64_t from, uint64_t to) {
+  std::fill_n(std::ostreambuf_iterator<char>(out), to - from, '\0');
+}
+
+vk::IndexType writeMeshFile(std::ostream &out,
+                            std::span<const Vertex> vertices,
+                            std::span<const uint32_t> indices,
+                            VertexFormat format) {
+  TRACE_SCOPE("writeMeshFile");
+  const auto &layout = vertexFormatInfo(format);
+  std::vector<std::byte> packed(vertices.size() * layout.bindingDescription.stride);
+  layout.pack(vertices, packed);
+
+  auto indexSize = vertices.size() <= std::numeric_limits<uint16_t>::max() + 1ull ? sizeof(uint16_t) : sizeof(uint32_t);
+  auto attributesEnd = sizeof(MeshFileHeader) + layout.attributeDescriptions.size() * sizeof(MeshFileAttribute);
+  MeshFileHeader header{
+      .magic = MeshFileHeader::MAGIC,
+      .version = MeshFileHeader::VERSION,
+      .vertexStride = layout.bindingDescription.stride,
+      .attributeCount = static_cast<uint32_t>(layout.attributeDescriptions.size()),
+      .vertexCount = vertices.size(),
+      .indexCount = indices.size(),
+      .indexSize = static_cast<uint32_t>(indexSize),
+      .reserved = 0,
+      .vertexOffset = alignBlock(attributesEnd),
+      .indexOffset = alignBlock(alignBlock(attributesEnd) + packed.size()),
+  };
+
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (const auto &description : layout.attributeDescriptions) {
+    MeshFileAttribute attribute{
+        .location = description.location,
+        .format = static_cast<uint32_t>(description.format),
+        .offset = description.offset,
+        .reserved = 0,
+    };
+    out.write(reinterpret_cast<const char *>(&attribute), sizeof(attribute));
+  }
+  writePadding(out, attributesEnd, header.vertexOffset);
+  out.write(reinterpret_cast<const char *>(packed.data()), static_cast<std::streamsize>(packed.size()));
+  writePadding(out, header.vertexOffset + packed.size(), header.indexOffset);
+  if (indexSize == sizeof(uint16_t)) {
+    writeIndices<uint16_t>(out, indices);
+  } else {
+    writeIndices<uint32_t>(out, indices);
+  }
+  if (!out) {
+    throw std::runtime_error("Failed writing mesh file");
+  }
+  return indexSize == sizeof(uint16_t) ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "mapped_file.hpp"
+#include "pipeline.hpp"
+
+// Binary mesh container: a header, one descriptor per vertex attribute, then the vertex and index blocks, each
+// starting at a 16 byte aligned offset. Fields are in native byte order and the blocks in the layout the gpu reads, so
+// they can be copied to staging memory straight from the mapping.
+struct MeshFileHeader {
+  static constexpr uint32_t MAGIC = 0x534d5456; // "VTMS"
+  static constexpr uint32_t VERSION = 1;
+
+  uint32_t magic;
+  uint32_t version;
+  uint32_t vertexStride;
+  uint32_t attributeCount;
+  uint64_t vertexCount;
+  uint64_t indexCount;
+  // 2 or 4
+  uint32_t indexSize;
+  uint32_t reserved;
+  // from the start of the file
+  uint64_t vertexOffset;
+  uint64_t indexOffset;
+};
+
+struct MeshFileAttribute {
+  uint32_t location;
+  // a VkFormat
+  uint32_t format;
+  uint32_t offset;
+  uint32_t reserved;
+};
+
+// A mapped and validated mesh file, the vertex and index blocks point into the mapping.
+class MeshFile {
+  const MappedFile file;
+
+public:
+  const MeshFileHeader header;
+  const std::vector<MeshFileAttribute> attributes;
+  const std::span<const std::byte> vertices;
+  const std::span<const std::byte> indices;
+
+  // throws if the file is truncated, not a mesh file or indexes past its vertices
+  explicit MeshFile(const std::filesystem::path &);
+
+  [[nodiscard]] size_t size() const { return file.bytes().size(); }
+  [[nodiscard]] vk::IndexType indexType() const;
+  [[nodiscard]] bool hasLayout(uint32_t stride, std::span<const vk::VertexInputAttributeDescription>) const;
+  // the VertexFormat whose layout the vertices are stored in, if any
+  [[nodiscard]] std::optional<VertexFormat> vertexFormat() const;
+};
+
+// vertices are stored quantized to the format, 16 bit indices are picked whenever the vertex count allows them.
+// Returns the index type written.
+vk::IndexType writeMeshFile(std::ostream &,
+                            std::span<const Vertex>,
+                            std::span<const uint32_t> indices,
+                            VertexFormat = VertexFormat::eFloat);
@@ -0,0 +1,261 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "trace.hpp"
+
+// vertices are compared bitwise, which needs them free of padding
+static_assert(sizeof(Vertex) == 5 * sizeof(float));
+
+struct VertexBitsHash {
+  size_t operator()(const Vertex &vertex) const {
+    std::array<uint32_t, sizeof(Vertex) / sizeof(uint32_t)> words;
+    std::memcpy(words.data(), &vertex, sizeof(vertex));
+    uint64_t hash = 14695981039346656037ull;
+    for (auto word : words) {
+      hash = (hash ^ word) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+  }
+};
+
+struct VertexBitsEqual {
+  bool operator()(const Vertex &a, const Vertex &b) const { return std::memcmp(&a, &b, sizeof(Vertex)) == 0; }
+};
+
+MeshData readMeshData(const MeshFile &mesh) {
+  TRACE_SCOPE("readMeshData");
+  const auto &layout = vertexFormatInfo(VertexFormat::eFloat);
+  if (!mesh.hasLayout(layout.bindingDescription.stride, layout.attributeDescriptions)) {
+    throw std::runtime_error("Only meshes stored with float vertices can be optimized");
+  }
+
+  MeshData result{
+      .vertices = std::vector<Vertex>(mesh.header.vertexCount),
+      .indices = std::vector<uint32_t>(mesh.header.indexCount),
+  };
+  std::memcpy(result.vertices.data(), mesh.vertices.data(), mesh.vertices.size_bytes());
+  if (mesh.indexType() == vk::IndexType::eUint32) {
+    std::memcpy(result.indices.data(), mesh.indices.data(), mesh.indices.size_bytes());
+  } else {
+    std::vector<uint16_t> narrow(mesh.header.indexCount);
+    std::memcpy(narrow.data(), mesh.indices.data(), mesh.indices.size_bytes());
+    std::ranges::copy(narrow, result.indices.begin());
+  }
+  return result;
+}
+
+VertexCacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize) {
+  // a vertex is cached while fewer than cacheSize misses happened since it was inserted
+  std::vector<size_t> insertedAt(vertexCount, 0);
+  size_t time = cacheSize + 1;
+  size_t misses = 0;
+  for (auto index : indices) {
+    if (time - insertedAt[index] > cacheSize) {
+      insertedAt[index] = time++;
+      misses++;
+    }
+  }
+  auto triangleCount = indices.size() / 3;
+  return {
+      .acmr = triangleCount == 0 ? 0.0f : static_cast<float>(misses) / triangleCount,
+      .atvr = vertexCount == 0 ? 0.0f : static_cast<float>(misses) / vertexCount,
+  };
+}
+
+void mergeDuplicateVertices(MeshData &mesh) {
+  std::unordered_map<Vertex, uint32_t, VertexBitsHash, VertexBitsEqual> unique;
+  unique.reserve(mesh.vertices.size());
+  std::vector<uint32_t> remap(mesh.vertices.size());
+  std::vector<Vertex> vertices;
+  for (size_t i = 0; i < mesh.vertices.size(); i++) {
+    auto [entry, inserted] = unique.try_emplace(mesh.vertices[i], static_cast<uint32_t>(vertices.size()));
+    if (inserted) {
+      vertices.push_back(mesh.vertices[i]);
+    }
+    remap[i] = entry->second;
+  }
+  for (auto &index : mesh.indices) {
+    index = remap[index];
+  }
+  mesh.vertices = std::move(vertices);
+}
+
+// Vertex to triangle adjacency in compressed rows, triangles of vertex v are triangles[offsets[v]..offsets[v + 1]].
+struct Adjacency {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> triangles;
+
+  Adjacency(std::span<const uint32_t> indices, size_t vertexCount) : offsets(vertexCount + 1, 0) {
+    for (auto index : indices) {
+      offsets[index + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+      offsets[v + 1] += offsets[v];
+    }
+    triangles.resize(indices.size());
+    auto cursor = std::vector<uint32_t>(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) {
+      triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+  }
+
+  [[nodiscard]] std::span<const uint32_t> of(uint32_t vertex) const {
+    return std::span(triangles).subspan(offsets[vertex], offsets[vertex + 1] - offsets[vertex]);
+  }
+};
+
+// Tipsify from Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw".
+// Triangles are emitted as fans around a vertex, the next fan is the one whose vertices are most likely still cached.
+// The paper's overdraw pass is left out: it sorts triangle clusters by facing, and 2D meshes all face the same way.
+void reorderForVertexCache(MeshData &mesh, uint32_t cacheSize) {
+  auto vertexCount = mesh.vertices.size();
+  auto triangleCount = mesh.indices.size() / 3;
+  Adjacency adjacency(mesh.indices, vertexCount);
+
+  std::vector<uint32_t> liveTriangles(vertexCount);
+  for (size_t v = 0; v < vertexCount; v++) {
+    liveTriangles[v] = static_cast<uint32_t>(adjacency.of(static_cast<uint32_t>(v)).size());
+  }
+  std::vector<size_t> cachedAt(vertexCount, 0);
+  std::vector<bool> emitted(triangleCount, false);
+  std::vector<uint32_t> deadEnds;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> indices;
+  indices.reserve(mesh.indices.size());
+  size_t time = cacheSize + 1;
+  size_t scan = 0;
+
+  // falls back to recently touched vertices, then to the next vertex in input order with triangles left
+  auto skipDeadEnd = [&]() -> int64_t {
+    while (!deadEnds.empty()) {
+      auto vertex = deadEnds.back();
+      deadEnds.pop_back();
+      if (liveTriangles[vertex] > 0) {
+        return vertex;
+      }
+    }
+    for (; scan < vertexCount; scan++) {
+      if (liveTriangles[scan] > 0) {
+        return static_cast<int64_t>(scan);
+      }
+    }
+    return -1;
+  };
+
+  int64_t fan = vertexCount == 0 ? -1 : skipDeadEnd();
+  while (fan >= 0) {
+    candidates.clear();
+    for (auto triangle : adjacency.of(static_cast<uint32_t>(fan))) {
+      if (emitted[triangle]) {
+        continue;
+      }
+      emitted[triangle] = true;
+      for (size_t corner = 0; corner < 3; corner++) {
+        auto vertex = mesh.indices[triangle * 3 + corner];
+        indices.push_back(vertex);
+        deadEnds.push_back(vertex);
+        candidates.push_back(vertex);
+        liveTriangles[vertex]--;
+        if (time - cachedAt[vertex] > cacheSize) {
+          cachedAt[vertex] = time++;
+        }
+      }
+    }
+
+    // prefer the oldest candidate that stays cached while its remaining triangles are emitted
+    int64_t next = -1;
+    int64_t bestPriority = -1;
+    for (auto vertex : candidates) {
+      if (liveTriangles[vertex] == 0) {
+        continue;
+      }
+      int64_t priority = 0;
+      if (time - cachedAt[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+        priority = static_cast<int64_t>(time - cachedAt[vertex]);
+      }
+      if (priority > bestPriority) {
+        next = vertex;
+        bestPriority = priority;
+      }
+    }
+    if (next < 0) {
+      next = skipDeadEnd();
+    }
+    fan = next;
+  }
+
+  mesh.indices = std::move(indices);
+}
+
+// numbers vertices in the order the index buffer first reads them and drops the ones it never reads
+void reorderForVertexFetch(MeshData &mesh) {
+  constexpr auto UNUSED = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+  std::vector<Vertex> vertices;
+  vertices.reserve(mesh.vertices.size());
+  for (auto &index : mesh.indices) {
+    if (remap[index] == UNUSED) {
+      remap[index] = static_cast<uint32_t>(vertices.size());
+      vertices.push_back(mesh.vertices[index]);
+    }
+    index = remap[index];
+  }
+  mesh.vertices = std::move(vertices);
+}
+
+MeshOptimizerReport optimizeMesh(MeshData &mesh, const MeshOptimizerSettings &settings) {
+  TRACE_SCOPE("optimizeMesh");
+  if (mesh.indices.size() % 3 != 0) {
+    throw std::runtime_error("Mesh index count isn't a multiple of 3");
+  }
+  if (std::ranges::any_of(mesh.indices, [&](auto index) { return index >= mesh.vertices.size(); })) {
+    throw std::runtime_error("Mesh index out of range");
+  }
+
+  MeshOptimizerReport report{
+      .verticesBefore = mesh.vertices.size(),
+      .verticesAfter = 0,
+      .before = analyzeVertexCache(mesh.indices, mesh.vertices.size(), settings.cacheSize),
+      .after = {},
+  };
+  mergeDuplicateVertices(mesh);
+  reorderForVertexCache(mesh, settings.cacheSize);
+  reorderForVertexFetch(mesh);
+  report.verticesAfter = mesh.vertices.size();
+  report.after = analyzeVertexCache(mesh.indices, mesh.vertices.size(), settings.cacheSize);
+  return report;
+}
+
+std::vector<MeshOptimizerReport> optimizeMeshes(std::span<MeshData> meshes,
+                                                ThreadPool &workers,
+                                                const MeshOptimizerSettings &settings) {
+  TRACE_SCOPE("optimizeMeshes");
+  std::vector<std::future<MeshOptimizerReport>> pending;
+  pending.reserve(meshes.size());
+  for (auto &mesh : meshes) {
+    pending.push_back(workers.submit([&mesh, &settings] { return optimizeMesh(mesh, settings); }));
+  }
+  // every task is waited for before rethrowing, they reference the meshes
+  std::vector<MeshOptimizerReport> reports;
+  std::exception_ptr error;
+  for (auto &report : pending) {
+    try {
+      reports.push_back(report.get());
+    } catch (...) {
+      error = error ? error : std::current_exception();
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return reports;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "mesh_file.hpp"
+#include "thread_pool.hpp"
+#include "vertex_layout.hpp"
+
+// An indexed triangle list kept in memory so it can be rewritten before upload.
+struct MeshData {
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+};
+
+// Post-transform cache efficiency of an index order, simulated with a FIFO cache. ACMR is vertices transformed per
+// triangle (0.5 at best on regular grids, 3 at worst), ATVR is vertices transformed per vertex (1 at best).
+struct VertexCacheStats {
+  float acmr;
+  float atvr;
+};
+
+struct MeshOptimizerSettings {
+  // entries of the simulated post-transform cache, the reorder targets this size
+  uint32_t cacheSize = 16;
+};
+
+struct MeshOptimizerReport {
+  size_t verticesBefore;
+  size_t verticesAfter;
+  VertexCacheStats before;
+  VertexCacheStats after;
+};
+
+// copies a mesh stored with float vertices out of its mapping, throws for packed files
+MeshData readMeshData(const MeshFile &);
+
+VertexCacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize);
+
+// Rewrites the mesh in place: merges bitwise identical vertices, reorders triangles for the post-transform cache
+// (Tipsify), then renumbers vertices in first use order for fetch locality and drops unreferenced ones. The triangles
+// drawn stay the same.
+MeshOptimizerReport optimizeMesh(MeshData &, const MeshOptimizerSettings & = {});
+// one task per mesh, the reports are in mesh order
+std::vector<MeshOptimizerReport> optimizeMeshes(std::span<MeshData>, ThreadPool &, const MeshOptimizerSettings & = {});
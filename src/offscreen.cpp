@@ -0,0 +1,45 @@
+#include "offscreen.hpp"
+
+#include "swapchain.hpp"
+#include "trace.hpp"
+
+Offscreen::Offscreen(const Device &device,
+                     const vk::raii::RenderPass &renderPass,
+                     const vk::Extent2D &extent,
+                     size_t imageCount)
+    : extent(extent) {
+  TRACE_SCOPE("Offscreen::Offscreen");
+  for (size_t i = 0; i < imageCount; i++) {
+    const auto &image = images.emplace_back(device.handle.createImage({
+        .imageType = vk::ImageType::e2D,
+        .format = device.details.format.format,
+        .extent = {extent.width, extent.height, 1},
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = vk::SampleCountFlagBits::e1,
+        .tiling = vk::ImageTiling::eOptimal,
+        .usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+        .sharingMode = vk::SharingMode::eExclusive,
+        .initialLayout = vk::ImageLayout::eUndefined,
+    }));
+    // images get their own memory, so they never share a block with linear buffers
+    const auto &allocation = allocations.emplace_back(device.allocator.allocate(
+        image.getMemoryRequirements(), vk::MemoryPropertyFlagBits::eDeviceLocal, true));
+    image.bindMemory(allocation.memory, allocation.offset);
+
+    views.push_back(device.handle.createImageView({
+        .image = *image,
+        .viewType = vk::ImageViewType::e2D,
+        .format = device.details.format.format,
+        .subresourceRange =
+            {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+    }));
+  }
+  framebuffers = createFramebuffers(renderPass, device.handle, views, extent);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "allocator.hpp"
+#include "device.hpp"
+
+// Color images standing in for a swapchain when rendering headless, one per frame in flight.
+struct Offscreen {
+  vk::Extent2D extent;
+  // declared first so the images are destroyed before their memory is released
+  std::vector<Allocation> allocations;
+  std::vector<vk::raii::Image> images;
+  std::vector<vk::raii::ImageView> views;
+  std::vector<vk::raii::Framebuffer> framebuffers;
+
+  Offscreen(const Device &, const vk::raii::RenderPass &, const vk::Extent2D &, size_t imageCount);
+};
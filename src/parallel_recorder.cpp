@@ -0,0 +1,32 @@
+#include "parallel_recorder.hpp"
+
+ParallelRecorder::ParallelRecorder(const vk::raii::Device &device,
+                                   uint32_t queueFamilyIndex,
+                                   size_t frameCount,
+                                   size_t threadCount) {
+  for (size_t frame = 0; frame < frameCount; frame++) {
+    auto &frameSlots = slots.emplace_back();
+    for (size_t thread = 0; thread < threadCount; thread++) {
+      auto commandPool = device.createCommandPool({
+          .flags = vk::CommandPoolCreateFlagBits::eTransient,
+          .queueFamilyIndex = queueFamilyIndex,
+      });
+      auto commandBuffers = device.allocateCommandBuffers({
+          .commandPool = *commandPool,
+          .level = vk::CommandBufferLevel::eSecondary,
+          .commandBufferCount = 1,
+      });
+      frameSlots.push_back({std::move(commandPool), std::move(commandBuffers[0])});
+    }
+  }
+}
+
+void ParallelRecorder::reset(size_t frameIndex) const {
+  for (const auto &slot : slots[frameIndex]) {
+    slot.commandPool.reset();
+  }
+}
+
+const vk::raii::CommandBuffer &ParallelRecorder::commandBuffer(size_t frameIndex, size_t thread) const {
+  return slots[frameIndex][thread].commandBuffer;
+}
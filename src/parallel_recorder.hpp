@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+// Command pools are externally synchronized, so every recording thread gets its own pool per frame in flight, each
+// holding one secondary command buffer. A frame's pools are reset wholesale once the pacer's timeline passed it.
+class ParallelRecorder {
+  struct Slot {
+    vk::raii::CommandPool commandPool;
+    vk::raii::CommandBuffer commandBuffer;
+  };
+
+  // indexed by frame, then by thread
+  std::vector<std::vector<Slot>> slots;
+
+public:
+  ParallelRecorder(const vk::raii::Device &, uint32_t queueFamilyIndex, size_t frameCount, size_t threadCount);
+
+  [[nodiscard]] size_t threadCount() const { return slots.empty() ? 0 : slots.front().size(); }
+
+  void reset(size_t frameIndex) const;
+  [[nodiscard]] const vk::raii::CommandBuffer &commandBuffer(size_t frameIndex, size_t thread) const;
+};
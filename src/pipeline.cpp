@@ -1,46 +1,140 @@
 #include "pipeline.hpp"
 
+#include <algorithm>
+#include <array>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace.hpp"
+
+#include "cull_compute_shader.h"
 #include "fragment_shader.h"
+#include "indirect_vertex_shader.h"
+#include "instanced_vertex_shader.h"
+#include "push_vertex_shader.h"
 #include "vertex_shader.h"
 
-vk::VertexInputBindingDescription Vertex::bindingDescription = {
-    .binding = 0,
-    .stride = sizeof(Vertex),
-    .inputRate = vk::VertexInputRate::eVertex,
+vk::VertexInputBindingDescription InstanceData::bindingDescription = {
+    .binding = 1,
+    .stride = sizeof(InstanceData),
+    .inputRate = vk::VertexInputRate::eInstance,
 };
 
-std::array<vk::VertexInputAttributeDescription, 2> Vertex::attributeDescriptions = {
+// a mat4 attribute takes one location per column
+std::array<vk::VertexInputAttributeDescription, 5> InstanceData::attributeDescriptions = {
     vk::VertexInputAttributeDescription{
-        .location = 0,
-        .binding = 0,
-        .format = vk::Format::eR32G32Sfloat,
-        .offset = offsetof(Vertex, pos),
+        .location = 2,
+        .binding = 1,
+        .format = vk::Format::eR32G32B32A32Sfloat,
+        .offset = offsetof(InstanceData, transform),
+    },
+    vk::VertexInputAttributeDescription{
+        .location = 3,
+        .binding = 1,
+        .format = vk::Format::eR32G32B32A32Sfloat,
+        .offset = offsetof(InstanceData, transform) + sizeof(glm::vec4),
+    },
+    vk::VertexInputAttributeDescription{
+        .location = 4,
+        .binding = 1,
+        .format = vk::Format::eR32G32B32A32Sfloat,
+        .offset = offsetof(InstanceData, transform) + 2 * sizeof(glm::vec4),
+    },
+    vk::VertexInputAttributeDescription{
+        .location = 5,
+        .binding = 1,
+        .format = vk::Format::eR32G32B32A32Sfloat,
+        .offset = offsetof(InstanceData, transform) + 3 * sizeof(glm::vec4),
     },
     vk::VertexInputAttributeDescription{
-        .location = 1,
+        .location = 6,
+        .binding = 1,
+        .format = vk::Format::eR32G32B32A32Sfloat,
+        .offset = offsetof(InstanceData, color),
+    },
+};
+
+const std::array<vk::DescriptorSetLayoutBinding, 1> Pipeline::descriptorSetBindings = {
+    vk::DescriptorSetLayoutBinding{
         .binding = 0,
-        .format = vk::Format::eR32G32B32Sfloat,
-        .offset = offsetof(Vertex, color),
+        .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
+        .descriptorCount = 1,
+        .stageFlags = vk::ShaderStageFlagBits::eVertex,
     },
 };
 
-vk::raii::DescriptorSetLayout createDescriptorSetLayout(const vk::raii::Device &device) {
-  auto layoutBindings = {vk::DescriptorSetLayoutBinding{
-      .binding = 0,
-      .descriptorType = vk::DescriptorType::eUniformBuffer,
-      .descriptorCount = 1,
-      .stageFlags = vk::ShaderStageFlagBits::eVertex,
-  }};
-  return device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{}.setBindings(layoutBindings));
+const std::array<vk::DescriptorSetLayoutBinding, 2> Pipeline::indirectDescriptorSetBindings = {
+    vk::DescriptorSetLayoutBinding{
+        .binding = 0,
+        .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
+        .descriptorCount = 1,
+        .stageFlags = vk::ShaderStageFlagBits::eVertex,
+    },
+    vk::DescriptorSetLayoutBinding{
+        .binding = 1,
+        .descriptorType = vk::DescriptorType::eStorageBuffer,
+        .descriptorCount = 1,
+        .stageFlags = vk::ShaderStageFlagBits::eVertex,
+    },
+};
+
+const std::array<vk::DescriptorSetLayoutBinding, 3> Pipeline::cullDescriptorSetBindings = {
+    vk::DescriptorSetLayoutBinding{
+        .binding = 0,
+        .descriptorType = vk::DescriptorType::eStorageBuffer,
+        .descriptorCount = 1,
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+    },
+    vk::DescriptorSetLayoutBinding{
+        .binding = 1,
+        .descriptorType = vk::DescriptorType::eStorageBuffer,
+        .descriptorCount = 1,
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+    },
+    vk::DescriptorSetLayoutBinding{
+        .binding = 2,
+        .descriptorType = vk::DescriptorType::eStorageBuffer,
+        .descriptorCount = 1,
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+    },
+};
+
+vk::raii::DescriptorSetLayout createDescriptorSetLayout(const vk::raii::Device &device,
+                                                        std::span<const vk::DescriptorSetLayoutBinding> bindings) {
+  return device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{}.setBindings(bindings));
 }
 
 vk::raii::PipelineLayout createPipelineLayout(const vk::raii::Device &device,
                                               const vk::raii::DescriptorSetLayout &descriptorSetLayout) {
   auto descriptorSetLayouts = {*descriptorSetLayout};
-  return device.createPipelineLayout(vk::PipelineLayoutCreateInfo{}.setSetLayouts(descriptorSetLayouts));
+  // only read by the push constant variant, the others ignore it and keep sharing the layout
+  auto pushConstantRanges = {vk::PushConstantRange{
+      .stageFlags = vk::ShaderStageFlagBits::eVertex,
+      .offset = 0,
+      .size = sizeof(ObjectPushConstants),
+  }};
+  return device.createPipelineLayout(
+      vk::PipelineLayoutCreateInfo{}.setSetLayouts(descriptorSetLayouts).setPushConstantRanges(pushConstantRanges));
+}
+
+vk::raii::PipelineLayout createCullPipelineLayout(const vk::raii::Device &device,
+                                                  const vk::raii::DescriptorSetLayout &descriptorSetLayout) {
+  auto descriptorSetLayouts = {*descriptorSetLayout};
+  auto pushConstantRanges = {vk::PushConstantRange{
+      .stageFlags = vk::ShaderStageFlagBits::eCompute,
+      .offset = 0,
+      .size = sizeof(CullPushConstants),
+  }};
+  return device.createPipelineLayout(
+      vk::PipelineLayoutCreateInfo{}.setSetLayouts(descriptorSetLayouts).setPushConstantRanges(pushConstantRanges));
 }
 
-vk::raii::RenderPass createRenderPass(const vk::Format &format, const vk::raii::Device &device) {
+vk::raii::RenderPass createRenderPass(const vk::Format &format,
+                                      vk::ImageLayout finalLayout,
+                                      const vk::raii::Device &device) {
+  TRACE_SCOPE("createRenderPass");
   auto attachments = {
       vk::AttachmentDescription{
           .format = format,
@@ -50,7 +144,7 @@ vk::raii::RenderPass createRenderPass(const vk::Format &format, const vk::raii::
           .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
           .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
           .initialLayout = vk::ImageLayout::eUndefined,
-          .finalLayout = vk::ImageLayout::ePresentSrcKHR,
+          .finalLayout = finalLayout,
       },
   };
   auto colorAttachmentReferences = {
@@ -82,8 +176,13 @@ vk::raii::RenderPass createRenderPass(const vk::Format &format, const vk::raii::
 
 vk::raii::Pipeline createPipeline(const vk::raii::Device &device,
                                   const vk::raii::PipelineLayout &layout,
-                                  const vk::raii::RenderPass &renderPass) {
-  auto vertexShader = device.createShaderModule(vk::ShaderModuleCreateInfo{}.setCode(vertex_shader_code));
+                                  const vk::raii::RenderPass &renderPass,
+                                  const vk::raii::PipelineCache &cache,
+                                  std::span<const uint32_t> vertexShaderCode,
+                                  std::span<const vk::VertexInputBindingDescription> bindingDescriptions,
+                                  std::span<const vk::VertexInputAttributeDescription> attributeDescriptions) {
+  TRACE_SCOPE("createPipeline");
+  auto vertexShader = device.createShaderModule(vk::ShaderModuleCreateInfo{}.setCode(vertexShaderCode));
   auto fragmentShader = device.createShaderModule(vk::ShaderModuleCreateInfo{}.setCode(fragment_shader_code));
   auto shaderStages = {
       vk::PipelineShaderStageCreateInfo{
@@ -103,13 +202,10 @@ vk::raii::Pipeline createPipeline(const vk::raii::Device &device,
       vk::DynamicState::eViewport,
       vk::DynamicState::eScissor,
   };
-  auto vertexInputBindingDescriptions = {
-      Vertex::bindingDescription,
-  };
   auto dynamicState = vk::PipelineDynamicStateCreateInfo{}.setDynamicStates(dynamicStates);
   auto vertexInput = vk::PipelineVertexInputStateCreateInfo{}
-                         .setVertexBindingDescriptions(vertexInputBindingDescriptions)
-                         .setVertexAttributeDescriptions(Vertex::attributeDescriptions);
+                         .setVertexBindingDescriptions(bindingDescriptions)
+                         .setVertexAttributeDescriptions(attributeDescriptions);
   auto inputAssembly = vk::PipelineInputAssemblyStateCreateInfo{
       .topology = vk::PrimitiveTopology::eTriangleList,
       .primitiveRestartEnable = false,
@@ -158,11 +254,157 @@ vk::raii::Pipeline createPipeline(const vk::raii::Device &device,
           .subpass = 0,
       }
           .setStages(shaderStages);
-  return device.createGraphicsPipeline(nullptr, graphicsPipelineCreateInfo);
+  return device.createGraphicsPipeline(cache, graphicsPipelineCreateInfo);
+}
+
+vk::raii::Pipeline createComputePipeline(const vk::raii::Device &device,
+                                         const vk::raii::PipelineLayout &layout,
+                                         const vk::raii::PipelineCache &cache,
+                                         std::span<const uint32_t> shaderCode) {
+  TRACE_SCOPE("createComputePipeline");
+  auto shader = device.createShaderModule(vk::ShaderModuleCreateInfo{}.setCode(shaderCode));
+  return device.createComputePipeline(cache,
+                                      vk::ComputePipelineCreateInfo{
+                                          .stage =
+                                              {
+                                                  .stage = vk::ShaderStageFlagBits::eCompute,
+                                                  .module = *shader,
+                                                  .pName = "main",
+                                              },
+                                          .layout = *layout,
+                                      });
+}
+
+uint64_t hashBytes(uint64_t hash, std::span<const std::byte> bytes) {
+  for (auto byte : bytes) {
+    hash ^= static_cast<uint64_t>(byte);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// FNV-1a over the state that differs between pipelines, the layout and render pass are shared by every pipeline
+// compiled by one Pipeline so they are left out
+uint64_t pipelineStateHash(std::span<const uint32_t> vertexShaderCode,
+                           std::span<const vk::VertexInputBindingDescription> bindingDescriptions,
+                           std::span<const vk::VertexInputAttributeDescription> attributeDescriptions) {
+  uint64_t hash = 14695981039346656037ull;
+  hash = hashBytes(hash, std::as_bytes(vertexShaderCode));
+  hash = hashBytes(hash, std::as_bytes(bindingDescriptions));
+  return hashBytes(hash, std::as_bytes(attributeDescriptions));
+}
+
+// the descriptions are copied, the shader code has to outlive the compile
+// meshes, instanced, push constant, indirect and cull
+const size_t PIPELINE_VARIANT_COUNT = 5;
+
+// half the cores at most, the rest are left to the record threads and the first frames. hardware_concurrency may be
+// 0 when it can't tell
+size_t compileThreadCount() {
+  auto cores = static_cast<size_t>(std::thread::hardware_concurrency());
+  return std::clamp<size_t>(cores / 2, 1, PIPELINE_VARIANT_COUNT);
+}
+
+PipelineCompiler::Future compilePipeline(PipelineCompiler &compiler,
+                                         std::string name,
+                                         const vk::raii::Device &device,
+                                         const vk::raii::PipelineLayout &layout,
+                                         const vk::raii::RenderPass &renderPass,
+                                         const vk::raii::PipelineCache &cache,
+                                         std::span<const uint32_t> vertexShaderCode,
+                                         std::vector<vk::VertexInputBindingDescription> bindingDescriptions,
+                                         std::vector<vk::VertexInputAttributeDescription> attributeDescriptions) {
+  auto stateHash = pipelineStateHash(vertexShaderCode, bindingDescriptions, attributeDescriptions);
+  return compiler.compile(stateHash,
+                          std::move(name),
+                          [&device,
+                           &layout,
+                           &renderPass,
+                           &cache,
+                           vertexShaderCode,
+                           bindingDescriptions = std::move(bindingDescriptions),
+                           attributeDescriptions = std::move(attributeDescriptions)] {
+                            return createPipeline(device,
+                                                  layout,
+                                                  renderPass,
+                                                  cache,
+                                                  vertexShaderCode,
+                                                  bindingDescriptions,
+                                                  attributeDescriptions);
+                          });
+}
+
+// the shader code has to outlive the compile
+PipelineCompiler::Future compileComputePipeline(PipelineCompiler &compiler,
+                                                std::string name,
+                                                const vk::raii::Device &device,
+                                                const vk::raii::PipelineLayout &layout,
+                                                const vk::raii::PipelineCache &cache,
+                                                std::span<const uint32_t> shaderCode) {
+  return compiler.compile(pipelineStateHash(shaderCode, {}, {}),
+                          std::move(name),
+                          [&device, &layout, &cache, shaderCode] {
+                            return createComputePipeline(device, layout, cache, shaderCode);
+                          });
+}
+
+std::vector<vk::VertexInputAttributeDescription> instanceAttributeDescriptions(const VertexFormatInfo &vertexFormat) {
+  std::vector<vk::VertexInputAttributeDescription> result(vertexFormat.attributeDescriptions.begin(),
+                                                          vertexFormat.attributeDescriptions.end());
+  result.insert(result.end(), InstanceData::attributeDescriptions.begin(), InstanceData::attributeDescriptions.end());
+  return result;
 }
 
-Pipeline::Pipeline(const vk::Format &format, const vk::raii::Device &device)
-    : descriptorSetLayout(createDescriptorSetLayout(device)),
+Pipeline::Pipeline(const vk::Format &format,
+                   vk::ImageLayout finalLayout,
+                   const vk::raii::Device &device,
+                   const vk::raii::PipelineCache &cache,
+                   VertexFormat vertexFormat)
+    : descriptorSetLayout(createDescriptorSetLayout(device, descriptorSetBindings)),
       pipelineLayout(createPipelineLayout(device, descriptorSetLayout)),
-      renderPass(createRenderPass(format, device)),
-      handle(createPipeline(device, pipelineLayout, renderPass)) {}
+      renderPass(createRenderPass(format, finalLayout, device)),
+      indirectDescriptorSetLayout(createDescriptorSetLayout(device, indirectDescriptorSetBindings)),
+      indirectPipelineLayout(createPipelineLayout(device, indirectDescriptorSetLayout)),
+      cullDescriptorSetLayout(createDescriptorSetLayout(device, cullDescriptorSetBindings)),
+      cullPipelineLayout(createCullPipelineLayout(device, cullDescriptorSetLayout)),
+      compiler(compileThreadCount()),
+      handle(compilePipeline(compiler,
+                             "meshes",
+                             device,
+                             pipelineLayout,
+                             renderPass,
+                             cache,
+                             vertex_shader_code,
+                             {vertexFormatInfo(vertexFormat).bindingDescription},
+                             {vertexFormatInfo(vertexFormat).attributeDescriptions.begin(),
+                              vertexFormatInfo(vertexFormat).attributeDescriptions.end()})),
+      instanced(compilePipeline(compiler,
+                                "instanced meshes",
+                                device,
+                                pipelineLayout,
+                                renderPass,
+                                cache,
+                                instanced_vertex_shader_code,
+                                {vertexFormatInfo(vertexFormat).bindingDescription, InstanceData::bindingDescription},
+                                instanceAttributeDescriptions(vertexFormatInfo(vertexFormat)))),
+      pushConstant(compilePipeline(compiler,
+                                   "push constant meshes",
+                                   device,
+                                   pipelineLayout,
+                                   renderPass,
+                                   cache,
+                                   push_vertex_shader_code,
+                                   {vertexFormatInfo(vertexFormat).bindingDescription},
+                                   {vertexFormatInfo(vertexFormat).attributeDescriptions.begin(),
+                                    vertexFormatInfo(vertexFormat).attributeDescriptions.end()})),
+      indirect(compilePipeline(compiler,
+                               "indirect meshes",
+                               device,
+                               indirectPipelineLayout,
+                               renderPass,
+                               cache,
+                               indirect_vertex_shader_code,
+                               {vertexFormatInfo(vertexFormat).bindingDescription},
+                               {vertexFormatInfo(vertexFormat).attributeDescriptions.begin(),
+                                vertexFormatInfo(vertexFormat).attributeDescriptions.end()})),
+      cull(compileComputePipeline(compiler, "cull", device, cullPipelineLayout, cache, cull_compute_shader_code)) {}
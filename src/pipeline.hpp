@@ -5,14 +5,21 @@
 #include <glm/glm.hpp>
 #include <vulkan/vulkan_raii.hpp>
 
+#include "frustum.hpp"
+#include "pipeline_compiler.hpp"
+#include "vertex_layout.hpp"
+
 using Index = uint16_t;
+// for Drawable indices, meshes loaded from files pick their own width
+constexpr vk::IndexType INDEX_TYPE = vk::IndexType::eUint16;
 
-struct Vertex {
+// per-instance attributes for the instanced pipeline, read from the second vertex binding
+struct InstanceData {
   static vk::VertexInputBindingDescription bindingDescription;
-  static std::array<vk::VertexInputAttributeDescription, 2> attributeDescriptions;
+  static std::array<vk::VertexInputAttributeDescription, 5> attributeDescriptions;
 
-  glm::vec2 pos;
-  glm::vec3 color;
+  glm::mat4 transform;
+  glm::vec4 color;
 };
 
 struct UniformBufferObject {
@@ -21,11 +28,52 @@ struct UniformBufferObject {
   glm::mat4 proj;
 };
 
+// matches the push constant block of shader_push.vert, everything else about an object stays in the per-frame ubo
+struct ObjectPushConstants {
+  glm::mat4 transform;
+};
+
+// matches the push constant block of cull.comp
+struct CullPushConstants {
+  Frustum planes;
+  // mesh bounding sphere in the space object transforms apply to, xyz center and w radius
+  glm::vec4 bounds;
+  uint32_t objectCount;
+  uint32_t indexCount;
+};
+
 struct Pipeline {
+  // bindings of the descriptor set layouts below, descriptor pools are sized from them
+  static const std::array<vk::DescriptorSetLayoutBinding, 1> descriptorSetBindings;
+  static const std::array<vk::DescriptorSetLayoutBinding, 2> indirectDescriptorSetBindings;
+  static const std::array<vk::DescriptorSetLayoutBinding, 3> cullDescriptorSetBindings;
+
   const vk::raii::DescriptorSetLayout descriptorSetLayout;
   const vk::raii::PipelineLayout pipelineLayout;
   const vk::raii::RenderPass renderPass;
-  const vk::raii::Pipeline handle;
+  // the ubo plus a storage buffer of InstanceData indexed by gl_InstanceIndex
+  const vk::raii::DescriptorSetLayout indirectDescriptorSetLayout;
+  const vk::raii::PipelineLayout indirectPipelineLayout;
+  // objects to cull, the draw commands written and their count, parameters come as CullPushConstants
+  const vk::raii::DescriptorSetLayout cullDescriptorSetLayout;
+  const vk::raii::PipelineLayout cullPipelineLayout;
+  // declared after everything its workers use, so queued compiles finish before those are destroyed
+  PipelineCompiler compiler;
+  // compiled asynchronously, get() blocks until the pipeline is ready
+  const PipelineCompiler::Future handle;
+  // draws one mesh many times, each instance transformed by its InstanceData
+  const PipelineCompiler::Future instanced;
+  // one draw per object like handle, the object transform comes as ObjectPushConstants
+  const PipelineCompiler::Future pushConstant;
+  // draws the commands a culling pass wrote, one per visible object
+  const PipelineCompiler::Future indirect;
+  // compute pipeline frustum culling objects into VkDrawIndexedIndirectCommands
+  const PipelineCompiler::Future cull;
 
-  Pipeline(const vk::Format &, const vk::raii::Device &);
+  // the graphics variants read vertices in the given format from the first binding
+  Pipeline(const vk::Format &,
+           vk::ImageLayout finalLayout,
+           const vk::raii::Device &,
+           const vk::raii::PipelineCache &,
+           VertexFormat);
 };
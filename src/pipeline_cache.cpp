@@ -0,0 +1,112 @@
+#include "pipeline_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "trace.hpp"
+
+// "VTPC"
+const uint32_t PIPELINE_CACHE_MAGIC = 0x43505456;
+
+struct PipelineCacheHeader {
+  uint32_t magic;
+  uint32_t vendorID;
+  uint32_t deviceID;
+  uint32_t driverVersion;
+  std::array<uint8_t, VK_UUID_SIZE> pipelineCacheUUID;
+  uint64_t dataSize;
+};
+
+PipelineCacheHeader pipelineCacheHeader(const vk::PhysicalDeviceProperties &properties, uint64_t dataSize) {
+  return {
+      .magic = PIPELINE_CACHE_MAGIC,
+      .vendorID = properties.vendorID,
+      .deviceID = properties.deviceID,
+      .driverVersion = properties.driverVersion,
+      .pipelineCacheUUID = properties.pipelineCacheUUID,
+      .dataSize = dataSize,
+  };
+}
+
+bool matches(const PipelineCacheHeader &header, const vk::PhysicalDeviceProperties &properties) {
+  auto expected = pipelineCacheHeader(properties, header.dataSize);
+  return header.magic == expected.magic && header.vendorID == expected.vendorID &&
+         header.deviceID == expected.deviceID && header.driverVersion == expected.driverVersion &&
+         header.pipelineCacheUUID == expected.pipelineCacheUUID;
+}
+
+std::vector<std::byte> loadCacheData(const std::filesystem::path &path,
+                                     const vk::PhysicalDeviceProperties &properties) {
+  std::error_code error;
+  auto fileSize = std::filesystem::file_size(path, error);
+  if (error || fileSize < sizeof(PipelineCacheHeader)) {
+    return {};
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  PipelineCacheHeader header;
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || !matches(header, properties) ||
+      header.dataSize != fileSize - sizeof(header)) {
+    return {};
+  }
+  std::vector<std::byte> data(header.dataSize);
+  if (!file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()))) {
+    return {};
+  }
+  return data;
+}
+
+vk::raii::PipelineCache createPipelineCache(const vk::raii::Device &device,
+                                            const std::filesystem::path &path,
+                                            const vk::PhysicalDeviceProperties &properties,
+                                            bool &loaded) {
+  TRACE_SCOPE("createPipelineCache");
+  auto data = path.empty() ? std::vector<std::byte>{} : loadCacheData(path, properties);
+  loaded = !data.empty();
+  return device.createPipelineCache({
+      .initialDataSize = data.size(),
+      .pInitialData = data.data(),
+  });
+}
+
+PipelineCache::PipelineCache(const vk::raii::Device &device,
+                             const vk::PhysicalDeviceProperties &properties,
+                             std::filesystem::path cachePath)
+    : path(std::move(cachePath)),
+      properties(properties),
+      handle(createPipelineCache(device, path, properties, loaded)) {}
+
+PipelineCache::~PipelineCache() {
+  try {
+    save();
+  } catch (const std::exception &e) {
+    std::cerr << "Failed saving pipeline cache: " << e.what() << "\n";
+  }
+}
+
+void PipelineCache::save() const {
+  TRACE_SCOPE("PipelineCache::save");
+  if (path.empty()) {
+    return;
+  }
+
+  auto data = handle.getData();
+  auto header = pipelineCacheHeader(properties, data.size());
+  auto temporaryPath = std::filesystem::path(path).concat(".tmp");
+  {
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    file.close();
+    if (!file) {
+      throw std::runtime_error("Failed writing " + temporaryPath.string());
+    }
+  }
+  // rename replaces the destination atomically
+  std::filesystem::rename(temporaryPath, path);
+}
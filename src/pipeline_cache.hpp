@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem>
+
+#include <vulkan/vulkan_raii.hpp>
+
+// A VkPipelineCache persisted between runs. The file is prefixed with the vendor, device, driver version and cache UUID
+// that produced it, data from any other device or driver is discarded instead of being handed to the driver. An empty
+// path keeps the cache in memory only.
+class PipelineCache {
+  const std::filesystem::path path;
+  const vk::PhysicalDeviceProperties properties;
+  bool loaded = false;
+
+public:
+  const vk::raii::PipelineCache handle;
+
+  PipelineCache(const vk::raii::Device &, const vk::PhysicalDeviceProperties &, std::filesystem::path);
+  // saves, errors are reported but not thrown
+  ~PipelineCache();
+
+  // whether valid data was loaded from disk
+  [[nodiscard]] bool warm() const { return loaded; }
+
+  // writes to a temporary file renamed over the previous one, so a crash never leaves a truncated cache behind
+  void save() const;
+};
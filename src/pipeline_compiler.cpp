@@ -0,0 +1,46 @@
+#include "pipeline_compiler.hpp"
+
+#include <algorithm>
+
+#include "trace.hpp"
+
+// compile runs tasks while holding the lock, so they must never run inline
+PipelineCompiler::PipelineCompiler(size_t threadCount) : workers(std::max<size_t>(threadCount, 1)) {}
+
+PipelineCompiler::Future PipelineCompiler::compile(uint64_t stateHash,
+                                                   std::string name,
+                                                   std::function<vk::raii::Pipeline()> create) {
+  std::scoped_lock lock(mutex);
+  if (auto pipeline = pipelines.find(stateHash); pipeline != pipelines.end()) {
+    return pipeline->second;
+  }
+
+  auto future = workers.submit([this, name = std::move(name), create = std::move(create)] {
+    TRACE_SCOPE("PipelineCompiler::compile");
+    auto start = std::chrono::steady_clock::now();
+    auto pipeline = create();
+    auto end = std::chrono::steady_clock::now();
+    std::scoped_lock lock(mutex);
+    compileTimings.push_back({name, start, end});
+    return pipeline;
+  });
+  return pipelines.emplace(stateHash, future.share()).first->second;
+}
+
+void PipelineCompiler::waitIdle() const {
+  std::vector<Future> pending;
+  {
+    std::scoped_lock lock(mutex);
+    for (const auto &[_, pipeline] : pipelines) {
+      pending.push_back(pipeline);
+    }
+  }
+  for (const auto &pipeline : pending) {
+    pipeline.wait();
+  }
+}
+
+std::vector<PipelineCompiler::Timing> PipelineCompiler::timings() const {
+  std::scoped_lock lock(mutex);
+  return compileTimings;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "thread_pool.hpp"
+
+// Creates pipelines on worker threads. Requests are keyed by a hash of the pipeline state, asking for a state that is
+// already compiling or compiled returns the same future. Pipeline caches are internally synchronized, so every worker
+// shares one.
+class PipelineCompiler {
+public:
+  using Future = std::shared_future<vk::raii::Pipeline>;
+
+  struct Timing {
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+  };
+
+private:
+  mutable std::mutex mutex;
+  std::unordered_map<uint64_t, Future> pipelines;
+  std::vector<Timing> compileTimings;
+  // declared last so queued compiles finish before anything they touch is destroyed
+  ThreadPool workers;
+
+public:
+  explicit PipelineCompiler(size_t threadCount);
+
+  Future compile(uint64_t stateHash, std::string name, std::function<vk::raii::Pipeline()> create);
+  // blocks until every requested pipeline has been created
+  void waitIdle() const;
+
+  // compiles that have finished, in completion order
+  [[nodiscard]] std::vector<Timing> timings() const;
+};
@@ -0,0 +1,40 @@
+#include "present_fences.hpp"
+
+#include <limits>
+#include <tuple>
+
+PresentFences::PresentFences(const vk::raii::Device &device) : device(device) {}
+
+PresentFences::~PresentFences() {
+  std::vector<vk::Fence> fences;
+  for (const auto &[value, fence] : pending) {
+    fences.push_back(*fence);
+  }
+  if (!fences.empty()) {
+    // nothing to report from a destructor, the fences are destroyed either way
+    std::ignore = device.waitForFences(fences, true, std::numeric_limits<uint64_t>::max());
+  }
+}
+
+const vk::raii::Fence &PresentFences::next() {
+  if (spare.empty()) {
+    spare.push_back(device.createFence({}));
+  }
+  return spare.back();
+}
+
+void PresentFences::queued(uint64_t value) {
+  pending.emplace_back(value, std::move(spare.back()));
+  spare.pop_back();
+}
+
+uint64_t PresentFences::collect() {
+  // presents are released in order, the first fence still unsignalled ends the walk
+  while (!pending.empty() && pending.front().second.getStatus() == vk::Result::eSuccess) {
+    released = pending.front().first;
+    device.resetFences({*pending.front().second});
+    spare.push_back(std::move(pending.front().second));
+    pending.pop_front();
+  }
+  return released;
+}
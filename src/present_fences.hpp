@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+// Tracks when the presentation engine lets go of what a present used, with the fences VK_EXT_swapchain_maintenance1
+// signals once a present's wait semaphores, image and swapchain are no longer in use. Every present is tagged with the
+// FramePacer value of its frame, so the values of the presents released so far tell when a replaced swapchain can be
+// destroyed. Fences are recycled once signalled.
+class PresentFences {
+  const vk::raii::Device &device;
+  // queued with a present, in pacer value order
+  std::deque<std::pair<uint64_t, vk::raii::Fence>> pending;
+  // unsignalled, the last one is handed out by next()
+  std::vector<vk::raii::Fence> spare;
+  uint64_t released = 0;
+
+public:
+  explicit PresentFences(const vk::raii::Device &);
+  // presents hold on to their fences until released, device idle doesn't cover them
+  ~PresentFences();
+
+  // the fence to chain into the next present with vk::SwapchainPresentFenceInfoEXT
+  const vk::raii::Fence &next();
+  // call once the present carrying next() was queued, an out of date present counts as queued
+  void queued(uint64_t value);
+  // recycles the fences signalled so far and returns releasedValue(), never blocks
+  uint64_t collect();
+  // every present tagged with a value up to this one was released by the presentation engine
+  [[nodiscard]] uint64_t releasedValue() const { return released; }
+};
@@ -0,0 +1,136 @@
+#include "present_monitor.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "stopwatch.hpp"
+#include "trace.hpp"
+
+PresentMonitor::PresentMonitor(const vk::raii::Device &device, const vk::raii::Semaphore &timeline, bool presentWait)
+    : device(device), timeline(timeline), presentWait(presentWait) {}
+
+void PresentMonitor::record(uint64_t value, Clock::time_point presented) {
+  while (!inFlight.empty() && inFlight.front().first <= value) {
+    latencies.push_back(std::chrono::duration<double, std::milli>(presented - inFlight.front().second).count());
+    if (latencies.size() > HISTORY_LENGTH) {
+      latencies.pop_front();
+    }
+    inFlight.pop_front();
+  }
+}
+
+// waits for the frames in submission order, a wait that returns late stamps every value reached by then at once
+void PresentMonitor::waitForCompletions(std::stop_token stop) {
+  uint64_t completed = 0;
+  try {
+    while (true) {
+      {
+        std::unique_lock lock(mutex);
+        if (!submittedChanged.wait(lock, stop, [&] { return lastSubmitted > completed; })) {
+          return;
+        }
+      }
+      auto semaphores = {*timeline};
+      auto values = {completed + 1};
+      auto result = device.waitSemaphores(vk::SemaphoreWaitInfo{}.setSemaphores(semaphores).setValues(values),
+                                          std::numeric_limits<uint64_t>::max());
+      auto now = Clock::now();
+      if (result != vk::Result::eSuccess) {
+        throw std::runtime_error("Failed waiting for frame");
+      }
+      completed = timeline.getCounterValue();
+      std::scoped_lock lock(mutex);
+      completions.emplace_back(completed, now);
+    }
+  } catch (...) {
+    std::scoped_lock lock(mutex);
+    completionError = std::current_exception();
+  }
+}
+
+void PresentMonitor::submitted(uint64_t value) {
+  inFlight.emplace_back(value, Clock::now());
+  if (presentWait) {
+    return;
+  }
+  {
+    std::scoped_lock lock(mutex);
+    lastSubmitted = value;
+  }
+  if (!completionThread.joinable()) {
+    completionThread = std::jthread([this](std::stop_token stop) { waitForCompletions(stop); });
+  }
+  submittedChanged.notify_one();
+}
+
+void PresentMonitor::poll(const vk::raii::SwapchainKHR &swapchain) {
+  if (!presentWait) {
+    std::vector<std::pair<uint64_t, Clock::time_point>> completed;
+    {
+      std::scoped_lock lock(mutex);
+      if (completionError) {
+        std::rethrow_exception(completionError);
+      }
+      completed.swap(completions);
+    }
+    for (const auto &[value, time] : completed) {
+      record(value, time);
+    }
+    return;
+  }
+  // presents complete in order, so the first one still pending ends the poll
+  try {
+    while (!inFlight.empty()) {
+      auto result = swapchain.waitForPresent(inFlight.front().first, 0);
+      // a suboptimal swapchain still presented the frame
+      if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
+        break;
+      }
+      record(inFlight.front().first, Clock::now());
+    }
+  } catch (const vk::OutOfDateKHRError &) {
+    // the swapchain is about to be recreated, which drops the frames still in flight
+  }
+}
+
+double PresentMonitor::limit(const vk::raii::SwapchainKHR &swapchain, uint32_t maxFrameLatency) {
+  if (maxFrameLatency == 0 || inFlight.size() <= maxFrameLatency) {
+    return 0.0;
+  }
+  TRACE_SCOPE("PresentMonitor::limit");
+  Stopwatch stopwatch;
+  // the newest frame that has to leave the queue for maxFrameLatency to remain
+  auto value = inFlight[inFlight.size() - maxFrameLatency - 1].first;
+  if (presentWait) {
+    try {
+      auto result = swapchain.waitForPresent(value, std::numeric_limits<uint64_t>::max());
+      if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
+        throw std::runtime_error("Failed waiting for present");
+      }
+    } catch (const vk::OutOfDateKHRError &) {
+      return stopwatch.lap();
+    }
+  } else {
+    auto semaphores = {*timeline};
+    auto values = {value};
+    auto result = device.waitSemaphores(vk::SemaphoreWaitInfo{}.setSemaphores(semaphores).setValues(values),
+                                        std::numeric_limits<uint64_t>::max());
+    if (result != vk::Result::eSuccess) {
+      throw std::runtime_error("Failed waiting for frame");
+    }
+    // stamped by the completion thread, recorded by this poll or the next one
+    poll(swapchain);
+    return stopwatch.lap();
+  }
+  record(value, Clock::now());
+  return stopwatch.lap();
+}
+
+double PresentMonitor::average() const {
+  if (latencies.empty()) {
+    return 0.0;
+  }
+  return std::accumulate(latencies.begin(), latencies.end(), 0.0) / static_cast<double>(latencies.size());
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+// Measures cpu submit to present latency per frame, and enforces PresentPolicy::maxFrameLatency. With
+// Device::Details::presentWait every present carries the pacer value of its frame as present id and the monitor polls
+// for it to reach the screen. Without it the monitor falls back to submit to gpu complete, which leaves out the time
+// spent queued for presentation, and bounds latency by gpu completion instead. Completion is stamped by a helper
+// thread blocked on the pacer's timeline, so the fallback measures when frames finished rather than when they were
+// seen finished.
+class PresentMonitor {
+public:
+  static constexpr size_t HISTORY_LENGTH = 128;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  const vk::raii::Device &device;
+  const vk::raii::Semaphore &timeline;
+  const bool presentWait;
+  // frames submitted but not seen presented yet, by pacer value
+  std::deque<std::pair<uint64_t, Clock::time_point>> inFlight;
+  std::deque<double> latencies;
+
+  // shared with the completion thread, only used without present wait
+  std::mutex mutex;
+  std::condition_variable_any submittedChanged;
+  uint64_t lastSubmitted = 0;
+  // timeline values and when the thread saw the gpu reach them, drained by poll
+  std::vector<std::pair<uint64_t, Clock::time_point>> completions;
+  std::exception_ptr completionError;
+  // started with the first frame submitted, declared last so it is joined before the state it shares
+  std::jthread completionThread;
+
+  void record(uint64_t value, Clock::time_point presented);
+  void waitForCompletions(std::stop_token);
+
+public:
+  PresentMonitor(const vk::raii::Device &, const vk::raii::Semaphore &timeline, bool presentWait);
+
+  [[nodiscard]] bool usesPresentWait() const { return presentWait; }
+  // what history() measures, for reports
+  [[nodiscard]] const char *metricName() const {
+    return presentWait ? "submit to present" : "submit to gpu complete";
+  }
+
+  // call right after submitting the frame that signals value
+  void submitted(uint64_t value);
+  // records the frames that reached the screen, or finished on the gpu without present wait, never blocks
+  void poll(const vk::raii::SwapchainKHR &);
+  // blocks until at most maxFrameLatency of the submitted frames are still waiting to be presented, returns the
+  // milliseconds spent blocked
+  double limit(const vk::raii::SwapchainKHR &, uint32_t maxFrameLatency);
+  // present ids belong to a swapchain, frames presented to a retired one are no longer measured. Completion on the
+  // timeline doesn't depend on the swapchain
+  void swapchainRecreated() {
+    if (presentWait) {
+      inFlight.clear();
+    }
+  }
+
+  // milliseconds of the most recent frames, oldest first
+  [[nodiscard]] const std::deque<double> &history() const { return latencies; }
+  [[nodiscard]] double average() const;
+};
@@ -0,0 +1,31 @@
+#include "ring_buffer.hpp"
+
+RingSlices::RingSlices(vk::DeviceSize alignment, vk::DeviceSize sliceSize, size_t sliceCount)
+    : alignment(alignment), sliceSize(alignUp(sliceSize, alignment)), sliceCount(sliceCount) {}
+
+void RingSlices::beginFrame(size_t frameIndex) {
+  head = frameIndex * sliceSize;
+  sliceEnd = head + sliceSize;
+}
+
+vk::DeviceSize RingSlices::allocate(vk::DeviceSize size) {
+  auto offset = alignUp(head, alignment);
+  if (offset + size > sliceEnd) {
+    throw std::runtime_error("Ring buffer slice exhausted");
+  }
+  head = offset + size;
+  return offset;
+}
+
+RingBuffer::RingBuffer(const vk::raii::Device &device,
+                       const Allocator &allocator,
+                       vk::BufferUsageFlags usage,
+                       vk::DeviceSize alignment,
+                       vk::DeviceSize sliceSize,
+                       size_t sliceCount)
+    : Buffer(device,
+             allocator,
+             alignUp(sliceSize, alignment) * sliceCount,
+             usage,
+             vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible),
+      RingSlices(alignment, sliceSize, sliceCount) {}
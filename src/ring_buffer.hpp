@@ -0,0 +1,58 @@
+#pragma once
+
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "buffer.hpp"
+
+// The offset bookkeeping of a RingBuffer, kept apart from the memory so it can be exercised without a device. Each
+// slice is a linear allocator rewound by beginFrame, offsets are aligned relative to the start of the whole buffer.
+class RingSlices {
+  vk::DeviceSize sliceEnd = 0;
+  vk::DeviceSize head = 0;
+
+public:
+  const vk::DeviceSize alignment;
+  // rounded up to the alignment, so every slice starts aligned
+  const vk::DeviceSize sliceSize;
+  const size_t sliceCount;
+
+  RingSlices(vk::DeviceSize alignment, vk::DeviceSize sliceSize, size_t sliceCount);
+
+  void beginFrame(size_t frameIndex);
+  // throws when the current slice has no room left
+  vk::DeviceSize allocate(vk::DeviceSize size);
+};
+
+// A persistently mapped buffer with one slice per frame in flight, each slice is a linear allocator reset at the start
+// of its frame. Offsets handed out are aligned for use as dynamic descriptor offsets.
+struct RingBuffer : Buffer, RingSlices {
+  RingBuffer(const vk::raii::Device &,
+             const Allocator &,
+             vk::BufferUsageFlags,
+             vk::DeviceSize alignment,
+             vk::DeviceSize sliceSize,
+             size_t sliceCount);
+
+  template <typename T>
+  [[nodiscard]] std::pair<uint32_t, std::span<T>> allocate(size_t count);
+
+  template <typename T>
+  uint32_t push(const T &value);
+};
+
+template <typename T>
+std::pair<uint32_t, std::span<T>> RingBuffer::allocate(size_t count) {
+  auto offset = RingSlices::allocate(sizeof(T) * count);
+  return {static_cast<uint32_t>(offset), {reinterpret_cast<T *>(allocation.mapped + offset), count}};
+}
+
+template <typename T>
+uint32_t RingBuffer::push(const T &value) {
+  auto [offset, data] = allocate<T>(1);
+  data[0] = value;
+  return offset;
+}
@@ -0,0 +1,408 @@
+#include "scene.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SCENE_X86_64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#include "trace.hpp"
+
+// msvc compiles intrinsics of any instruction set as is, gcc and clang need the function to opt in
+#if defined(SCENE_X86_64) && !defined(_MSC_VER)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+// indexed by CullKernel
+const std::array<const char *, 3> CULL_KERNEL_NAMES = {"scalar", "sse", "avx2"};
+
+const char *cullKernelName(CullKernel kernel) {
+  return CULL_KERNEL_NAMES.at(static_cast<size_t>(kernel));
+}
+
+std::optional<CullKernel> parseCullKernel(std::string_view name) {
+  auto kernel = std::ranges::find_if(CULL_KERNEL_NAMES, [&](const char *kernel) { return name == kernel; });
+  if (kernel == CULL_KERNEL_NAMES.end()) {
+    return std::nullopt;
+  }
+  return static_cast<CullKernel>(kernel - CULL_KERNEL_NAMES.begin());
+}
+
+#if defined(SCENE_X86_64) && defined(_MSC_VER)
+bool cpuSupportsAvx2() {
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  // the os has to save the ymm registers on context switches
+  bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+  __cpuidex(info, 7, 0);
+  return avx && (info[1] & (1 << 5));
+}
+#endif
+
+bool supportsCullKernel(CullKernel kernel) {
+  switch (kernel) {
+  case CullKernel::eScalar:
+    return true;
+#ifdef SCENE_X86_64
+  case CullKernel::eSse:
+    return true;
+  case CullKernel::eAvx2: {
+#ifdef _MSC_VER
+    static const bool avx2 = cpuSupportsAvx2();
+    return avx2;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+  }
+#endif
+  default:
+    return false;
+  }
+}
+
+CullKernel bestCullKernel() {
+  static const CullKernel best = supportsCullKernel(CullKernel::eAvx2) ? CullKernel::eAvx2
+                                 : supportsCullKernel(CullKernel::eSse) ? CullKernel::eSse
+                                                                         : CullKernel::eScalar;
+  return best;
+}
+
+// the scene's world space bounds as seen by a kernel
+struct CullBounds {
+  const float *centerX;
+  const float *centerY;
+  const float *centerZ;
+  const float *radius;
+  const float *extentX;
+  const float *extentY;
+  const float *extentZ;
+};
+
+// culls objects [begin, end), appends the visible indices to out and returns the new end of out
+using CullFunction = uint32_t *(*)(const CullBounds &, const Frustum &, uint32_t begin, uint32_t end, uint32_t *out);
+
+// An object is culled when its volume lies entirely behind one plane: distance to the plane plus the volume's reach
+// towards it below zero. The vector kernels evaluate the same expressions in the same order without fused
+// multiply-adds, so they round like the scalar kernel and keep the same objects unless the compiler contracts the
+// scalar one into fused multiply-adds.
+template <CullVolume volume>
+uint32_t *cullScalar(const CullBounds &bounds, const Frustum &frustum, uint32_t begin, uint32_t end, uint32_t *out) {
+  for (auto i = begin; i < end; i++) {
+    bool inside = true;
+    for (const auto &plane : frustum) {
+      float distance =
+          plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+      float reach;
+      if constexpr (volume == CullVolume::eSphere) {
+        reach = bounds.radius[i];
+      } else {
+        reach = std::abs(plane.x) * bounds.extentX[i] + std::abs(plane.y) * bounds.extentY[i] +
+                std::abs(plane.z) * bounds.extentZ[i];
+      }
+      if (!(distance + reach >= 0.0f)) {
+        inside = false;
+        break;
+      }
+    }
+    if (inside) {
+      *out++ = i;
+    }
+  }
+  return out;
+}
+
+#ifdef SCENE_X86_64
+template <CullVolume volume>
+uint32_t *cullSse(const CullBounds &bounds, const Frustum &frustum, uint32_t begin, uint32_t end, uint32_t *out) {
+  __m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+  for (size_t p = 0; p < frustum.size(); p++) {
+    planeX[p] = _mm_set1_ps(frustum[p].x);
+    planeY[p] = _mm_set1_ps(frustum[p].y);
+    planeZ[p] = _mm_set1_ps(frustum[p].z);
+    planeW[p] = _mm_set1_ps(frustum[p].w);
+    absX[p] = _mm_set1_ps(std::abs(frustum[p].x));
+    absY[p] = _mm_set1_ps(std::abs(frustum[p].y));
+    absZ[p] = _mm_set1_ps(std::abs(frustum[p].z));
+  }
+
+  auto i = begin;
+  for (; i + 4 <= end; i += 4) {
+    auto x = _mm_loadu_ps(bounds.centerX + i);
+    auto y = _mm_loadu_ps(bounds.centerY + i);
+    auto z = _mm_loadu_ps(bounds.centerZ + i);
+    auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (size_t p = 0; p < frustum.size(); p++) {
+      auto distance = _mm_add_ps(
+          _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_mul_ps(planeZ[p], z)),
+          planeW[p]);
+      __m128 reach;
+      if constexpr (volume == CullVolume::eSphere) {
+        reach = _mm_loadu_ps(bounds.radius + i);
+      } else {
+        reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], _mm_loadu_ps(bounds.extentX + i)),
+                                      _mm_mul_ps(absY[p], _mm_loadu_ps(bounds.extentY + i))),
+                           _mm_mul_ps(absZ[p], _mm_loadu_ps(bounds.extentZ + i)));
+      }
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+    }
+    // one bit per object, compacted into out in ascending order
+    for (auto mask = static_cast<uint32_t>(_mm_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+      *out++ = i + std::countr_zero(mask);
+    }
+  }
+  return cullScalar<volume>(bounds, frustum, i, end, out);
+}
+
+template <CullVolume volume>
+TARGET_AVX2 uint32_t *cullAvx2(
+    const CullBounds &bounds, const Frustum &frustum, uint32_t begin, uint32_t end, uint32_t *out) {
+  __m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+  for (size_t p = 0; p < frustum.size(); p++) {
+    planeX[p] = _mm256_set1_ps(frustum[p].x);
+    planeY[p] = _mm256_set1_ps(frustum[p].y);
+    planeZ[p] = _mm256_set1_ps(frustum[p].z);
+    planeW[p] = _mm256_set1_ps(frustum[p].w);
+    absX[p] = _mm256_set1_ps(std::abs(frustum[p].x));
+    absY[p] = _mm256_set1_ps(std::abs(frustum[p].y));
+    absZ[p] = _mm256_set1_ps(std::abs(frustum[p].z));
+  }
+
+  auto i = begin;
+  for (; i + 8 <= end; i += 8) {
+    auto x = _mm256_loadu_ps(bounds.centerX + i);
+    auto y = _mm256_loadu_ps(bounds.centerY + i);
+    auto z = _mm256_loadu_ps(bounds.centerZ + i);
+    auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (size_t p = 0; p < frustum.size(); p++) {
+      auto distance = _mm256_add_ps(
+          _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+                        _mm256_mul_ps(planeZ[p], z)),
+          planeW[p]);
+      __m256 reach;
+      if constexpr (volume == CullVolume::eSphere) {
+        reach = _mm256_loadu_ps(bounds.radius + i);
+      } else {
+        reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[p], _mm256_loadu_ps(bounds.extentX + i)),
+                                            _mm256_mul_ps(absY[p], _mm256_loadu_ps(bounds.extentY + i))),
+                              _mm256_mul_ps(absZ[p], _mm256_loadu_ps(bounds.extentZ + i)));
+      }
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_GE_OQ));
+    }
+    for (auto mask = static_cast<uint32_t>(_mm256_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+      *out++ = i + std::countr_zero(mask);
+    }
+  }
+  return cullScalar<volume>(bounds, frustum, i, end, out);
+}
+#endif
+
+CullFunction cullFunction(CullKernel kernel, CullVolume volume) {
+  bool sphere = volume == CullVolume::eSphere;
+  switch (kernel) {
+#ifdef SCENE_X86_64
+  case CullKernel::eSse:
+    return sphere ? &cullSse<CullVolume::eSphere> : &cullSse<CullVolume::eBox>;
+  case CullKernel::eAvx2:
+    return sphere ? &cullAvx2<CullVolume::eSphere> : &cullAvx2<CullVolume::eBox>;
+#endif
+  default:
+    return sphere ? &cullScalar<CullVolume::eSphere> : &cullScalar<CullVolume::eBox>;
+  }
+}
+
+// objects below this are not worth a task of their own
+const size_t TRANSFORM_BATCH_SIZE = 1024;
+
+// result = a * b for column major 4x4 matrices, the batches keep the fixed operand in registers across objects
+inline void multiply(const glm::mat4 &a, const glm::mat4 &b, float *result) {
+#ifdef SCENE_X86_64
+  auto a0 = _mm_loadu_ps(&a[0][0]);
+  auto a1 = _mm_loadu_ps(&a[1][0]);
+  auto a2 = _mm_loadu_ps(&a[2][0]);
+  auto a3 = _mm_loadu_ps(&a[3][0]);
+  for (int column = 0; column < 4; column++) {
+    // each column of the result combines the columns of a weighted by one column of b
+    const float *weights = &b[column][0];
+    auto sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(weights[0])), _mm_mul_ps(a1, _mm_set1_ps(weights[1]))),
+                          _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(weights[2])), _mm_mul_ps(a3, _mm_set1_ps(weights[3]))));
+    _mm_storeu_ps(result + 4 * column, sum);
+  }
+#else
+  auto product = a * b;
+  std::memcpy(result, &product[0][0], sizeof(product));
+#endif
+}
+
+// runs body over [0, count) split into contiguous ranges, one task per worker, and waits for all of them
+template <typename F>
+void parallelFor(ThreadPool &workers, size_t count, const F &body) {
+  auto taskCount = std::clamp<size_t>(count / TRANSFORM_BATCH_SIZE, 1, std::max<size_t>(workers.size(), 1));
+  std::vector<std::future<void>> pending;
+  for (size_t task = 1; task < taskCount; task++) {
+    pending.push_back(workers.submit([&, task] { body(count * task / taskCount, count * (task + 1) / taskCount); }));
+  }
+  // the calling thread takes the first range instead of idling
+  std::exception_ptr error;
+  try {
+    body(0, count / taskCount);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // every task references body, all of them finish before an error is rethrown
+  for (auto &task : pending) {
+    try {
+      task.get();
+    } catch (...) {
+      error = error ? error : std::current_exception();
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+uint32_t Scene::add(const glm::mat4 &transform, const glm::vec4 &color, const glm::vec4 &bounds) {
+  localTransforms.push_back(transform);
+  worldTransforms.push_back(transform);
+  colors.push_back(color);
+  localBounds.push_back(bounds);
+  for (auto *component : {&centerX, &centerY, &centerZ, &radius, &extentX, &extentY, &extentZ}) {
+    component->push_back(0.0f);
+  }
+  dirty.push_back(false);
+  auto index = static_cast<uint32_t>(localTransforms.size() - 1);
+  setTransform(index, transform);
+  return index;
+}
+
+void Scene::setTransform(uint32_t index, const glm::mat4 &transform) {
+  localTransforms[index] = transform;
+  if (!dirty[index]) {
+    dirty[index] = true;
+    dirtyObjects.push_back(index);
+  }
+}
+
+void Scene::setModel(const glm::mat4 &transform) {
+  model = transform;
+  modelChanged = true;
+}
+
+size_t Scene::update(ThreadPool &workers) {
+  TRACE_SCOPE("Scene::update");
+  size_t updated = modelChanged ? size() : dirtyObjects.size();
+  if (modelChanged) {
+    parallelFor(workers, size(), [&](size_t begin, size_t end) {
+      for (auto i = static_cast<uint32_t>(begin); i < end; i++) {
+        updateObject(i);
+      }
+    });
+  } else {
+    parallelFor(workers, dirtyObjects.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        updateObject(dirtyObjects[i]);
+      }
+    });
+  }
+  // vector<bool> packs bits, clearing them from several threads would race
+  for (auto index : dirtyObjects) {
+    dirty[index] = false;
+  }
+  dirtyObjects.clear();
+  modelChanged = false;
+  return updated;
+}
+
+void Scene::updateObject(uint32_t index) {
+  auto &transform = worldTransforms[index];
+  multiply(localTransforms[index], model, &transform[0][0]);
+
+  const auto &bounds = localBounds[index];
+  auto center = glm::vec3(transform * glm::vec4(glm::vec3(bounds), 1.0f));
+  centerX[index] = center.x;
+  centerY[index] = center.y;
+  centerZ[index] = center.z;
+
+  auto axisX = glm::vec3(transform[0]);
+  auto axisY = glm::vec3(transform[1]);
+  auto axisZ = glm::vec3(transform[2]);
+  radius[index] = bounds.w * std::max({glm::length(axisX), glm::length(axisY), glm::length(axisZ)});
+  // the world box around the transformed cube enclosing the sphere
+  auto extent = bounds.w * (glm::abs(axisX) + glm::abs(axisY) + glm::abs(axisZ));
+  extentX[index] = extent.x;
+  extentY[index] = extent.y;
+  extentZ[index] = extent.z;
+}
+
+void Scene::writeTransforms(std::span<const uint32_t> objects,
+                            std::byte *destination,
+                            size_t stride,
+                            ThreadPool &workers) const {
+  writeMatrices(objects, nullptr, destination, stride, workers);
+}
+
+void Scene::writeMvps(std::span<const uint32_t> objects,
+                      const glm::mat4 &clipFromWorld,
+                      std::byte *destination,
+                      size_t stride,
+                      ThreadPool &workers) const {
+  writeMatrices(objects, &clipFromWorld, destination, stride, workers);
+}
+
+void Scene::writeMatrices(std::span<const uint32_t> objects,
+                          const glm::mat4 *clipFromWorld,
+                          std::byte *destination,
+                          size_t stride,
+                          ThreadPool &workers) const {
+  TRACE_SCOPE("Scene::writeMatrices");
+  parallelFor(workers, objects.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      // unaligned stores, the destination may be any mapped slot and is only ever written
+      auto *matrix = reinterpret_cast<float *>(destination + i * stride);
+      const auto &world = worldTransforms[objects[i]];
+      if (clipFromWorld) {
+        multiply(*clipFromWorld, world, matrix);
+      } else {
+        std::memcpy(matrix, &world[0][0], sizeof(world));
+      }
+    }
+  });
+}
+
+void Scene::cull(const Frustum &frustum, std::vector<uint32_t> &visible, CullVolume volume, CullKernel kernel) const {
+  TRACE_SCOPE("Scene::cull");
+  if (!supportsCullKernel(kernel)) {
+    throw std::runtime_error(std::string("Culling kernel not supported: ") + cullKernelName(kernel));
+  }
+  auto bounds = CullBounds{
+      .centerX = centerX.data(),
+      .centerY = centerY.data(),
+      .centerZ = centerZ.data(),
+      .radius = radius.data(),
+      .extentX = extentX.data(),
+      .extentY = extentY.data(),
+      .extentZ = extentZ.data(),
+  };
+  // sized for everything visible, trimmed to what the kernel wrote
+  visible.resize(size());
+  auto end = cullFunction(kernel, volume)(bounds, frustum, 0, static_cast<uint32_t>(size()), visible.data());
+  visible.resize(end - visible.data());
+}
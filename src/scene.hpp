@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "frustum.hpp"
+#include "thread_pool.hpp"
+
+// bounding volume the culling kernels test, both are derived from an object's bounding sphere
+enum class CullVolume {
+  eSphere,
+  // axis aligned box around the transformed sphere's cube, tighter for objects scaled unevenly
+  eBox,
+};
+
+// instruction set of a culling kernel, wider ones test more objects per instruction
+enum class CullKernel {
+  eScalar,
+  // 4 objects per instruction, baseline on x86-64
+  eSse,
+  // 8 objects per instruction
+  eAvx2,
+};
+
+const char *cullKernelName(CullKernel);
+// accepts the names cullKernelName returns
+std::optional<CullKernel> parseCullKernel(std::string_view);
+// whether the running cpu can execute the kernel, always true for the scalar one
+[[nodiscard]] bool supportsCullKernel(CullKernel);
+// the widest supported kernel
+CullKernel bestCullKernel();
+
+// Objects stored as a structure of arrays. Culling only reads the world space bounds, kept in one tightly packed array
+// per component so a vector register loads the same component of consecutive objects with a single instruction.
+// Transforms are set lazily: setTransform and setModel only mark objects dirty, update recomputes the world matrices
+// and bounds of the dirty ones in batches spread over a thread pool.
+class Scene {
+  std::vector<glm::mat4> localTransforms;
+  // localTransforms[i] * model, valid after update
+  std::vector<glm::mat4> worldTransforms;
+  std::vector<glm::vec4> colors;
+  // bounding sphere before the transform, xyz center and w radius
+  std::vector<glm::vec4> localBounds;
+
+  // world space, the box shares the sphere's center
+  std::vector<float> centerX;
+  std::vector<float> centerY;
+  std::vector<float> centerZ;
+  std::vector<float> radius;
+  std::vector<float> extentX;
+  std::vector<float> extentY;
+  std::vector<float> extentZ;
+
+  glm::mat4 model = glm::mat4(1.0f);
+  // every object is dirty after the model changed, the list is skipped then
+  bool modelChanged = false;
+  std::vector<uint32_t> dirtyObjects;
+  std::vector<bool> dirty;
+
+  void updateObject(uint32_t index);
+  void writeMatrices(std::span<const uint32_t> objects,
+                     const glm::mat4 *clipFromWorld,
+                     std::byte *destination,
+                     size_t stride,
+                     ThreadPool &) const;
+
+public:
+  // returns the index of the new object, dirty until the next update
+  uint32_t add(const glm::mat4 &transform, const glm::vec4 &color, const glm::vec4 &bounds);
+  void setTransform(uint32_t index, const glm::mat4 &);
+  // applied in every object's own space before its transform, e.g. a spin shared by all objects
+  void setModel(const glm::mat4 &);
+  // recomputes the world matrices and bounds of dirty objects, returns how many were dirty
+  size_t update(ThreadPool &);
+
+  [[nodiscard]] size_t size() const { return localTransforms.size(); }
+  // world transform as of the last update
+  [[nodiscard]] const glm::mat4 &transform(uint32_t index) const { return worldTransforms[index]; }
+  [[nodiscard]] const glm::vec4 &color(uint32_t index) const { return colors[index]; }
+
+  // writes the world matrix of each listed object stride bytes apart, straight into mapped gpu memory for example
+  void writeTransforms(std::span<const uint32_t> objects, std::byte *destination, size_t stride, ThreadPool &) const;
+  // same for clipFromWorld * world, the model view projection matrices
+  void writeMvps(std::span<const uint32_t> objects,
+                 const glm::mat4 &clipFromWorld,
+                 std::byte *destination,
+                 size_t stride,
+                 ThreadPool &) const;
+
+  // replaces visible with the ascending indices of the objects intersecting the frustum as of the last update.
+  // Conservative: objects near a corner of the frustum may be kept although they are outside.
+  void cull(const Frustum &,
+            std::vector<uint32_t> &visible,
+            CullVolume = CullVolume::eSphere,
+            CullKernel = bestCullKernel()) const;
+};
@@ -0,0 +1,29 @@
+#version 450
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+struct Object {
+    mat4 transform;
+    vec4 color;
+};
+
+layout(std430, binding = 1) readonly buffer Objects {
+    Object objects[];
+};
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    // each culled draw is a single instance whose first instance is the object index, model spins every object
+    // around its own origin
+    Object object = objects[gl_InstanceIndex];
+    gl_Position = ubo.proj * ubo.view * object.transform * ubo.model * vec4(inPosition, 0.0, 1.0);
+    fragColor = inColor * object.color.rgb;
+}
@@ -0,0 +1,23 @@
+#version 450
+
+// written once per frame, model applies to every object
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// per draw, no descriptor bind or buffer write between objects
+layout(push_constant) uniform Object {
+    mat4 transform;
+} object;
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = ubo.proj * ubo.view * object.transform * ubo.model * vec4(inPosition, 0.0, 1.0);
+    fragColor = inColor;
+}
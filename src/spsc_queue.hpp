@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+// Bounded first in first out queue between exactly one producer thread and one consumer thread, without locks. The
+// indices only ever grow, a slot is index % Capacity, so full and empty are told apart without a spare slot.
+template <typename T, size_t Capacity>
+class SpscQueue {
+  static_assert(std::has_single_bit(Capacity), "the capacity has to be a power of two");
+
+  std::array<T, Capacity> slots{};
+  // next slot to pop, advanced by the consumer
+  alignas(64) std::atomic<size_t> head = 0;
+  // next slot to push, advanced by the producer
+  alignas(64) std::atomic<size_t> tail = 0;
+
+public:
+  SpscQueue() = default;
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  // producer thread, false when the queue is full
+  bool push(T value) {
+    auto index = tail.load(std::memory_order_relaxed);
+    if (index - head.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    slots[index % Capacity] = std::move(value);
+    tail.store(index + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer thread, empty when there is nothing to pop
+  std::optional<T> pop() {
+    auto index = head.load(std::memory_order_relaxed);
+    if (index == tail.load(std::memory_order_acquire)) {
+      return std::nullopt;
+    }
+    auto value = std::move(slots[index % Capacity]);
+    head.store(index + 1, std::memory_order_release);
+    return value;
+  }
+};
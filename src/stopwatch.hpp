@@ -0,0 +1,16 @@
+#pragma once
+
+#include <chrono>
+
+// Measures consecutive intervals in milliseconds.
+class Stopwatch {
+  std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+
+public:
+  double lap() {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration<double, std::milli>(now - last).count();
+    last = now;
+    return elapsed;
+  }
+};
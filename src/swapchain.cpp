@@ -1,30 +1,65 @@
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <utility>
 
 #include "swapchain.hpp"
+#include "trace.hpp"
 
-vk::Extent2D determineExtent(const vkfw::Window &window, const vk::SurfaceCapabilitiesKHR &capabilities) {
+const std::array<std::pair<vk::PresentModeKHR, const char *>, 4> PRESENT_MODE_NAMES = {{
+    {vk::PresentModeKHR::eFifo, "fifo"},
+    {vk::PresentModeKHR::eFifoRelaxed, "fifo-relaxed"},
+    {vk::PresentModeKHR::eMailbox, "mailbox"},
+    {vk::PresentModeKHR::eImmediate, "immediate"},
+}};
+
+const char *presentModeName(vk::PresentModeKHR mode) {
+  auto entry = std::ranges::find(PRESENT_MODE_NAMES, mode, &std::pair<vk::PresentModeKHR, const char *>::first);
+  return entry == PRESENT_MODE_NAMES.end() ? "other" : entry->second;
+}
+
+std::optional<vk::PresentModeKHR> parsePresentMode(std::string_view name) {
+  auto entry = std::ranges::find_if(PRESENT_MODE_NAMES, [&](const auto &entry) { return name == entry.second; });
+  if (entry == PRESENT_MODE_NAMES.end()) {
+    return std::nullopt;
+  }
+  return entry->first;
+}
+
+// every surface supports fifo
+vk::PresentModeKHR pickPresentMode(const std::vector<vk::PresentModeKHR> &presentModes, vk::PresentModeKHR preferred) {
+  if (std::ranges::find(presentModes, preferred) != presentModes.end()) {
+    return preferred;
+  }
+  return vk::PresentModeKHR::eFifo;
+}
+
+vk::Extent2D determineExtent(const vk::Extent2D &framebufferSize, const vk::SurfaceCapabilitiesKHR &capabilities) {
   if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
     return capabilities.currentExtent;
   } else {
-    auto [realWidth, realHeight] = static_cast<std::tuple<uint32_t, uint32_t>>(window.getFramebufferSize());
     return {
-        std::clamp(realWidth, capabilities.minImageExtent.width, capabilities.maxImageExtent.width),
-        std::clamp(realHeight, capabilities.minImageExtent.height, capabilities.maxImageExtent.height),
+        std::clamp(framebufferSize.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width),
+        std::clamp(framebufferSize.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height),
     };
   }
 }
 
-uint32_t determineMinImageCount(const vk::SurfaceCapabilitiesKHR &capabilities) {
-  if (capabilities.maxImageCount == 0) {
-    return capabilities.minImageCount + 1;
-  } else {
-    return capabilities.maxImageCount;
+// every image beyond what the present mode needs is memory and, with fifo, another frame of queueing latency
+uint32_t determineMinImageCount(const vk::SurfaceCapabilitiesKHR &capabilities, const PresentPolicy &policy) {
+  auto requested = policy.imageCount == 0 ? capabilities.minImageCount + 1 : policy.imageCount;
+  requested = std::max(requested, capabilities.minImageCount);
+  // a maximum of 0 means there is none
+  if (capabilities.maxImageCount != 0) {
+    requested = std::min(requested, capabilities.maxImageCount);
   }
+  return requested;
 }
 
 std::vector<vk::raii::ImageView> createImages(const vk::raii::SwapchainKHR &swapchain,
                                               const vk::raii::Device &device,
                                               const vk::Format &format) {
+  TRACE_SCOPE("createImages");
   auto swapchainImages = swapchain.getImages();
 
   std::vector<vk::raii::ImageView> result;
@@ -49,15 +84,17 @@ std::vector<vk::raii::ImageView> createImages(const vk::raii::SwapchainKHR &swap
   return result;
 }
 
-vk::raii::SwapchainKHR createSwapchain(const vkfw::Window &window,
-                                       const vk::raii::SurfaceKHR &surface,
+vk::raii::SwapchainKHR createSwapchain(const vk::raii::SurfaceKHR &surface,
                                        const Device &device,
                                        const vk::SurfaceCapabilitiesKHR &surfaceCapabilities,
                                        const vk::Extent2D &extent,
+                                       vk::PresentModeKHR presentMode,
+                                       const PresentPolicy &policy,
                                        const vk::SwapchainKHR &oldSwapchain) {
+  TRACE_SCOPE("createSwapchain");
   return device.handle.createSwapchainKHR({
       .surface = *surface,
-      .minImageCount = determineMinImageCount(surfaceCapabilities),
+      .minImageCount = determineMinImageCount(surfaceCapabilities, policy),
       .imageFormat = device.details.format.format,
       .imageColorSpace = device.details.format.colorSpace,
       .imageExtent = extent,
@@ -66,7 +103,7 @@ vk::raii::SwapchainKHR createSwapchain(const vkfw::Window &window,
       .imageSharingMode = vk::SharingMode::eExclusive,
       .preTransform = surfaceCapabilities.currentTransform,
       .compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
-      .presentMode = device.details.presentMode,
+      .presentMode = presentMode,
       .clipped = true,
       .oldSwapchain = oldSwapchain,
   });
@@ -76,6 +113,7 @@ std::vector<vk::raii::Framebuffer> createFramebuffers(const vk::raii::RenderPass
                                                       const vk::raii::Device &device,
                                                       const std::vector<vk::raii::ImageView> &images,
                                                       const vk::Extent2D &extent) {
+  TRACE_SCOPE("createFramebuffers");
   std::vector<vk::raii::Framebuffer> result;
   result.reserve(images.size());
 
@@ -97,27 +135,15 @@ std::vector<vk::raii::Framebuffer> createFramebuffers(const vk::raii::RenderPass
   return result;
 }
 
-Swapchain::Swapchain(const vkfw::Window &window,
+Swapchain::Swapchain(const vk::Extent2D &framebufferSize,
                      const vk::raii::SurfaceKHR &surface,
                      const Device &device,
                      const vk::raii::RenderPass &renderPass,
+                     const PresentPolicy &policy,
                      const vk::SwapchainKHR &swapchain)
     : surfaceCapabilities(device.details.physicalDevice.getSurfaceCapabilitiesKHR(*surface)),
-      extent(determineExtent(window, surfaceCapabilities)),
-      handle(device.handle.createSwapchainKHR({
-          .surface = *surface,
-          .minImageCount = determineMinImageCount(surfaceCapabilities),
-          .imageFormat = device.details.format.format,
-          .imageColorSpace = device.details.format.colorSpace,
-          .imageExtent = extent,
-          .imageArrayLayers = 1,
-          .imageUsage = vk::ImageUsageFlagBits::eColorAttachment,
-          .imageSharingMode = vk::SharingMode::eExclusive,
-          .preTransform = surfaceCapabilities.currentTransform,
-          .compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
-          .presentMode = device.details.presentMode,
-          .clipped = true,
-          .oldSwapchain = swapchain,
-      })),
+      extent(determineExtent(framebufferSize, surfaceCapabilities)),
+      presentMode(pickPresentMode(device.details.presentModes, policy.mode)),
+      handle(createSwapchain(surface, device, surfaceCapabilities, extent, presentMode, policy, swapchain)),
       images(createImages(handle, device.handle, device.details.format.format)),
       framebuffers(createFramebuffers(renderPass, device.handle, images, extent)) {}
@@ -1,20 +1,48 @@
 #pragma once
 
-#include <vkfw/vkfw.hpp>
+#include <optional>
+#include <string_view>
+
 #include <vulkan/vulkan_raii.hpp>
 
 #include "device.hpp"
 
+// How frames are handed to the display, tuned for throughput or for latency.
+struct PresentPolicy {
+  // fifo when the surface doesn't support it. Mailbox and immediate don't block on vblank, fifo queues up to the
+  // image count worth of frames
+  vk::PresentModeKHR mode = vk::PresentModeKHR::eMailbox;
+  // swapchain images to ask for, clamped to what the surface allows. 0 asks for one more than the surface's minimum
+  uint32_t imageCount = 0;
+  // presents that may still be queued when the cpu starts a frame, 0 leaves only the frames in flight as the limit
+  uint32_t maxFrameLatency = 0;
+};
+
+const char *presentModeName(vk::PresentModeKHR);
+// accepts fifo, fifo-relaxed, mailbox and immediate
+std::optional<vk::PresentModeKHR> parsePresentMode(std::string_view);
+// the policy's image count, or one more than the surface's minimum without one, clamped to the surface's range
+uint32_t determineMinImageCount(const vk::SurfaceCapabilitiesKHR &, const PresentPolicy &);
+
+std::vector<vk::raii::Framebuffer> createFramebuffers(const vk::raii::RenderPass &,
+                                                      const vk::raii::Device &,
+                                                      const std::vector<vk::raii::ImageView> &,
+                                                      const vk::Extent2D &);
+
 struct Swapchain {
   vk::SurfaceCapabilitiesKHR surfaceCapabilities;
   vk::Extent2D extent;
+  // the policy's mode if the surface supports it
+  vk::PresentModeKHR presentMode;
   vk::raii::SwapchainKHR handle;
   std::vector<vk::raii::ImageView> images;
   std::vector<vk::raii::Framebuffer> framebuffers;
 
-  Swapchain(const vkfw::Window &,
+  // the framebuffer size is only used on surfaces that leave the extent to the swapchain
+  Swapchain(const vk::Extent2D &framebufferSize,
             const vk::raii::SurfaceKHR &,
             const Device &device,
             const vk::raii::RenderPass &,
+            const PresentPolicy &,
             const vk::SwapchainKHR & = VK_NULL_HANDLE);
 };
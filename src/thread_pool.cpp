@@ -0,0 +1,35 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(size_t threadCount) {
+  for (size_t i = 0; i < threadCount; i++) {
+    workers.emplace_back([this] { run(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::scoped_lock lock(mutex);
+    stopping = true;
+  }
+  available.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock(mutex);
+      available.wait(lock, [this] { return stopping || !tasks.empty(); });
+      // queued work is drained before stopping
+      if (tasks.empty()) {
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+    task();
+  }
+}
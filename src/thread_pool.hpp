@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads pulling tasks from a shared queue. A pool without workers runs every task inline on
+// the submitting thread, so callers don't need a separate serial path.
+class ThreadPool {
+  std::mutex mutex;
+  std::condition_variable available;
+  std::queue<std::function<void()>> tasks;
+  bool stopping = false;
+  std::vector<std::thread> workers;
+
+  void run();
+
+public:
+  explicit ThreadPool(size_t threadCount);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  [[nodiscard]] size_t size() const { return workers.size(); }
+
+  // exceptions thrown by the task are rethrown from the future
+  template <typename F>
+  std::future<std::invoke_result_t<F>> submit(F &&function);
+};
+
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::submit(F &&function) {
+  // std::function needs a copyable target, packaged_task is move only
+  auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(function));
+  auto result = task->get_future();
+  if (workers.empty()) {
+    (*task)();
+    return result;
+  }
+
+  {
+    std::scoped_lock lock(mutex);
+    tasks.emplace([task] { (*task)(); });
+  }
+  available.notify_one();
+  return result;
+}
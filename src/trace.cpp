@@ -0,0 +1,90 @@
+#include "trace.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent {
+  const char *name;
+  uint64_t start;
+  uint64_t end;
+};
+
+// Only the owning thread appends, readers see events up to the published size.
+struct TraceChunk {
+  static constexpr size_t CAPACITY = 4096;
+
+  std::array<TraceEvent, CAPACITY> events;
+  std::atomic<size_t> size = 0;
+  std::atomic<TraceChunk *> next = nullptr;
+};
+
+struct ThreadTrace {
+  const size_t threadId;
+  std::vector<std::unique_ptr<TraceChunk>> chunks;
+  TraceChunk *first;
+  TraceChunk *last;
+
+  explicit ThreadTrace(size_t threadId) : threadId(threadId) {
+    chunks.push_back(std::make_unique<TraceChunk>());
+    first = last = chunks.back().get();
+  }
+
+  void record(const TraceEvent &event) {
+    auto size = last->size.load(std::memory_order_relaxed);
+    if (size == TraceChunk::CAPACITY) {
+      // the vector is only touched by this thread, readers follow next pointers
+      auto chunk = chunks.emplace_back(std::make_unique<TraceChunk>()).get();
+      last->next.store(chunk, std::memory_order_release);
+      last = chunk;
+      size = 0;
+    }
+    last->events[size] = event;
+    last->size.store(size + 1, std::memory_order_release);
+  }
+};
+
+// threads register once, their traces live until exit so they can be dumped after the thread is gone
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadTrace>> registry;
+
+ThreadTrace &threadTrace() {
+  thread_local ThreadTrace *trace = [] {
+    std::scoped_lock lock(registryMutex);
+    return registry.emplace_back(std::make_unique<ThreadTrace>(registry.size())).get();
+  }();
+  return *trace;
+}
+
+uint64_t traceClock() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+TraceScope::TraceScope(const char *name) : name(name), start(traceClock()) {}
+
+TraceScope::~TraceScope() {
+  threadTrace().record({.name = name, .start = start, .end = traceClock()});
+}
+
+void dumpTrace(std::ostream &out) {
+  std::scoped_lock lock(registryMutex);
+  out << "{\"traceEvents\": [";
+  bool first = true;
+  for (const auto &trace : registry) {
+    for (auto chunk = trace->first; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+      auto size = chunk->size.load(std::memory_order_acquire);
+      for (size_t i = 0; i < size; i++) {
+        const auto &event = chunk->events[i];
+        out << (first ? "\n" : ",\n") << "{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+            << trace->threadId << ", \"ts\": " << event.start / 1000.0
+            << ", \"dur\": " << (event.end - event.start) / 1000.0 << "}";
+        first = false;
+      }
+    }
+  }
+  out << "\n]}\n";
+}
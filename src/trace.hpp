@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+// Scoped cpu tracing into per-thread buffers. TRACE_SCOPE compiles to nothing unless ENABLE_TRACING is defined.
+
+class TraceScope {
+  const char *name;
+  const uint64_t start;
+
+public:
+  // name must outlive the trace, string literals in practice
+  explicit TraceScope(const char *name);
+  ~TraceScope();
+};
+
+// writes every event recorded so far as chrome / perfetto trace event json
+void dumpTrace(std::ostream &);
+
+#ifdef ENABLE_TRACING
+// callers offering a trace export check this, without tracing compiled in the dump would be empty
+constexpr bool TRACING_ENABLED = true;
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) const TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+constexpr bool TRACING_ENABLED = false;
+#define TRACE_SCOPE(name)
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Hands the latest value from one writer thread to one reader thread without locks or blocking. Each side owns a slot
+// of its own and they trade through a shared middle slot, so the writer never waits for the reader and the reader
+// always sees a complete value: the newest one published, or the one it already had when nothing newer arrived.
+// Values the reader didn't get to in time are skipped.
+template <typename T>
+class TripleBuffer {
+  // set in middle while it holds a value the reader hasn't taken
+  static constexpr uint8_t FRESH = 4;
+
+  std::array<T, 3> slots;
+  // written by the writer only
+  uint8_t back = 0;
+  alignas(64) std::atomic<uint8_t> middle = 1;
+  // read by the reader only
+  alignas(64) uint8_t front = 2;
+
+public:
+  explicit TripleBuffer(const T &initial) : slots{initial, initial, initial} {}
+
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+  // writer thread
+  void write(const T &value) {
+    slots[back] = value;
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+  }
+
+  // reader thread, valid until the next read
+  const T &read() {
+    if (middle.load(std::memory_order_relaxed) & FRESH) {
+      front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+    }
+    return slots[front];
+  }
+};
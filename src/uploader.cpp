@@ -0,0 +1,233 @@
+#include "uploader.hpp"
+
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+#include "trace.hpp"
+
+vk::raii::CommandPool createUploadCommandPool(const vk::raii::Device &device, uint32_t queueFamilyIndex) {
+  return device.createCommandPool({
+      .flags = vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+      .queueFamilyIndex = queueFamilyIndex,
+  });
+}
+
+vk::raii::Semaphore createUploadTimeline(const vk::raii::Device &device) {
+  vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> createInfo = {
+      vk::SemaphoreCreateInfo{},
+      vk::SemaphoreTypeCreateInfo{
+          .semaphoreType = vk::SemaphoreType::eTimeline,
+          .initialValue = 0,
+      },
+  };
+  return device.createSemaphore(createInfo.get<vk::SemaphoreCreateInfo>());
+}
+
+// the release and the acquire must describe the same transfer, only their access masks differ
+std::vector<vk::BufferMemoryBarrier> ownershipBarriers(const std::vector<vk::Buffer> &buffers,
+                                                       vk::AccessFlags srcAccessMask,
+                                                       vk::AccessFlags dstAccessMask,
+                                                       uint32_t srcQueueFamilyIndex,
+                                                       uint32_t dstQueueFamilyIndex) {
+  std::vector<vk::BufferMemoryBarrier> barriers;
+  barriers.reserve(buffers.size());
+  for (auto buffer : buffers) {
+    barriers.push_back({
+        .srcAccessMask = srcAccessMask,
+        .dstAccessMask = dstAccessMask,
+        .srcQueueFamilyIndex = srcQueueFamilyIndex,
+        .dstQueueFamilyIndex = dstQueueFamilyIndex,
+        .buffer = buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    });
+  }
+  return barriers;
+}
+
+Uploader::Uploader(const vk::raii::Device &device,
+                   const Allocator &allocator,
+                   const vk::raii::Queue &transferQueue,
+                   uint32_t transferQueueFamilyIndex,
+                   const vk::raii::Queue &graphicsQueue,
+                   uint32_t graphicsQueueFamilyIndex)
+    : device(device),
+      allocator(allocator),
+      queue(transferQueue),
+      queueFamilyIndex(transferQueueFamilyIndex),
+      graphicsQueue(graphicsQueue),
+      graphicsQueueFamilyIndex(graphicsQueueFamilyIndex),
+      commandPool(createUploadCommandPool(device, transferQueueFamilyIndex)),
+      acquireCommandPool(createUploadCommandPool(device, graphicsQueueFamilyIndex)),
+      transferred(createUploadTimeline(device)) {}
+
+Uploader::Batch &Uploader::currentBatch() {
+  if (recording) {
+    return *recording;
+  }
+
+  if (retired.empty()) {
+    auto allocateCommandBuffer = [&](const vk::raii::CommandPool &pool) {
+      return std::move(device.allocateCommandBuffers({
+          .commandPool = *pool,
+          .level = vk::CommandBufferLevel::ePrimary,
+          .commandBufferCount = 1,
+      })[0]);
+    };
+    recording.emplace(Batch{
+        .ticket = nextTicket,
+        .commandBuffer = allocateCommandBuffer(commandPool),
+        .acquireCommandBuffer = transfersOwnership() ? allocateCommandBuffer(acquireCommandPool) : nullptr,
+        .fence = device.createFence({}),
+    });
+  } else {
+    recording.emplace(std::move(retired.back()));
+    retired.pop_back();
+    recording->ticket = nextTicket;
+    recording->commandBuffer.reset();
+    if (*recording->acquireCommandBuffer) {
+      recording->acquireCommandBuffer.reset();
+    }
+    recording->destinations.clear();
+    device.resetFences({*recording->fence});
+  }
+  nextTicket++;
+
+  recording->commandBuffer.begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+  return *recording;
+}
+
+Uploader::Ticket Uploader::copy(const Buffer &source, const Buffer &destination) {
+  auto &batch = currentBatch();
+  batch.commandBuffer.copyBuffer(*source.buffer, *destination.buffer, {{.size = source.size}});
+  batch.destinations.push_back(*destination.buffer);
+  return batch.ticket;
+}
+
+Uploader::Ticket Uploader::upload(std::span<const std::byte> data, const Buffer &destination) {
+  TRACE_SCOPE("Uploader::upload");
+  auto &batch = currentBatch();
+  const auto &stagingBuffer = *batch.stagingBuffers.emplace_back(
+      std::make_unique<const HostBuffer>(device, allocator, data, vk::BufferUsageFlagBits::eTransferSrc));
+  return copy(stagingBuffer, destination);
+}
+
+std::pair<Uploader::Ticket, std::span<std::byte>> Uploader::stage(const Buffer &destination) {
+  TRACE_SCOPE("Uploader::stage");
+  auto &batch = currentBatch();
+  const auto &stagingBuffer = *batch.stagingBuffers.emplace_back(
+      std::make_unique<const HostBuffer>(device, allocator, destination.size, vk::BufferUsageFlagBits::eTransferSrc));
+  return {copy(stagingBuffer, destination), {stagingBuffer.allocation.mapped, stagingBuffer.size}};
+}
+
+Uploader::Ticket Uploader::flush() {
+  TRACE_SCOPE("Uploader::flush");
+  if (!recording) {
+    return nextTicket - 1;
+  }
+
+  if (transfersOwnership()) {
+    submitWithOwnershipTransfer(*recording);
+  } else {
+    // make the copies visible to everything submitted after this batch
+    auto memoryBarriers = {vk::MemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eMemoryRead,
+    }};
+    recording->commandBuffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, memoryBarriers, {}, {});
+    recording->commandBuffer.end();
+
+    queue.submit({vk::SubmitInfo{}.setCommandBuffers(*recording->commandBuffer)}, *recording->fence);
+  }
+  pending.push_back(std::move(*recording));
+  recording.reset();
+  return pending.back().ticket;
+}
+
+void Uploader::submitWithOwnershipTransfer(Batch &batch) {
+  // release: the second half of the transfer is done by the acquire, so nothing on this queue waits for it
+  auto releaseBarriers = ownershipBarriers(
+      batch.destinations, vk::AccessFlagBits::eTransferWrite, {}, queueFamilyIndex, graphicsQueueFamilyIndex);
+  batch.commandBuffer.pipelineBarrier(
+      vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, releaseBarriers, {});
+  batch.commandBuffer.end();
+
+  auto signalSemaphores = {*transferred};
+  auto signalValues = {batch.ticket};
+  vk::StructureChain<vk::SubmitInfo, vk::TimelineSemaphoreSubmitInfo> releaseSubmit = {
+      vk::SubmitInfo{}.setCommandBuffers(*batch.commandBuffer).setSignalSemaphores(signalSemaphores),
+      vk::TimelineSemaphoreSubmitInfo{}.setSignalSemaphoreValues(signalValues),
+  };
+  queue.submit({releaseSubmit.get<vk::SubmitInfo>()});
+
+  // acquire: makes the copies visible to everything submitted to the graphics queue after this batch
+  auto acquireBarriers = ownershipBarriers(
+      batch.destinations, {}, vk::AccessFlagBits::eMemoryRead, queueFamilyIndex, graphicsQueueFamilyIndex);
+  batch.acquireCommandBuffer.begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+  batch.acquireCommandBuffer.pipelineBarrier(
+      vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands, {}, {}, acquireBarriers, {});
+  batch.acquireCommandBuffer.end();
+
+  std::array<vk::PipelineStageFlags, 1> waitStages = {vk::PipelineStageFlagBits::eAllCommands};
+  vk::StructureChain<vk::SubmitInfo, vk::TimelineSemaphoreSubmitInfo> acquireSubmit = {
+      vk::SubmitInfo{}
+          .setWaitSemaphores(signalSemaphores)
+          .setWaitDstStageMask(waitStages)
+          .setCommandBuffers(*batch.acquireCommandBuffer),
+      vk::TimelineSemaphoreSubmitInfo{}.setWaitSemaphoreValues(signalValues),
+  };
+  graphicsQueue.submit({acquireSubmit.get<vk::SubmitInfo>()}, *batch.fence);
+}
+
+void Uploader::collect() {
+  while (!pending.empty() && pending.front().fence.getStatus() == vk::Result::eSuccess) {
+    pending.front().stagingBuffers.clear();
+    retired.push_back(std::move(pending.front()));
+    pending.pop_front();
+  }
+}
+
+void Uploader::wait(Ticket ticket) {
+  TRACE_SCOPE("Uploader::wait");
+  if (recording && recording->ticket <= ticket) {
+    flush();
+  }
+
+  std::vector<vk::Fence> fences;
+  for (const auto &batch : pending) {
+    if (batch.ticket <= ticket) {
+      fences.push_back(*batch.fence);
+    }
+  }
+  if (!fences.empty()) {
+    auto result = device.waitForFences(fences, true, std::numeric_limits<uint64_t>::max());
+    if (result != vk::Result::eSuccess) {
+      throw std::runtime_error("Failed waiting for upload");
+    }
+  }
+  collect();
+}
+
+bool Uploader::isComplete(Ticket ticket) const {
+  if (recording && recording->ticket <= ticket) {
+    return false;
+  }
+  return pending.empty() || ticket < pending.front().ticket;
+}
+
+vk::DeviceSize Uploader::stagingBytes() const {
+  vk::DeviceSize result = 0;
+  for (const auto &batch : pending) {
+    for (const auto &stagingBuffer : batch.stagingBuffers) {
+      result += stagingBuffer->size;
+    }
+  }
+  if (recording) {
+    for (const auto &stagingBuffer : recording->stagingBuffers) {
+      result += stagingBuffer->size;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "buffer.hpp"
+
+// Records staging copies into one command buffer per batch. Each submitted batch signals its own fence, tickets
+// identify batches so callers can poll or wait on them without stalling the queue. Staging buffers belong to their
+// batch and are returned to the allocator once it retires.
+// Given a transfer queue from a family other than the graphics one, copies run there alongside rendering and the
+// destinations are handed over to the graphics family: the batch releases them on the transfer queue, signals a
+// timeline semaphore with its ticket, and a second command buffer on the graphics queue waits for that value and
+// acquires them before the fence signals. With one family for both the batch is a single submit as before.
+class Uploader {
+public:
+  using Ticket = uint64_t;
+
+private:
+  struct Batch {
+    Ticket ticket;
+    vk::raii::CommandBuffer commandBuffer;
+    // recorded on the graphics family when ownership is transferred, null otherwise
+    vk::raii::CommandBuffer acquireCommandBuffer;
+    vk::raii::Fence fence;
+    std::vector<std::unique_ptr<const HostBuffer>> stagingBuffers;
+    // buffers written by the batch, released to the graphics family when it is flushed
+    std::vector<vk::Buffer> destinations;
+  };
+
+  const vk::raii::Device &device;
+  const Allocator &allocator;
+  const vk::raii::Queue &queue;
+  const uint32_t queueFamilyIndex;
+  const vk::raii::Queue &graphicsQueue;
+  const uint32_t graphicsQueueFamilyIndex;
+  const vk::raii::CommandPool commandPool;
+  const vk::raii::CommandPool acquireCommandPool;
+  // reaches a batch's ticket once its copies and release barriers completed on the transfer queue
+  const vk::raii::Semaphore transferred;
+
+  std::optional<Batch> recording;
+  // submitted, in ticket order
+  std::deque<Batch> pending;
+  std::vector<Batch> retired;
+  Ticket nextTicket = 1;
+
+  Batch &currentBatch();
+  void submitWithOwnershipTransfer(Batch &);
+
+public:
+  // the transfer queue may be the graphics queue, in which case no ownership is transferred
+  Uploader(const vk::raii::Device &,
+           const Allocator &,
+           const vk::raii::Queue &transferQueue,
+           uint32_t transferQueueFamilyIndex,
+           const vk::raii::Queue &graphicsQueue,
+           uint32_t graphicsQueueFamilyIndex);
+
+  // the source is read on the transfer queue, with a dedicated one it must not be owned by the graphics family
+  Ticket copy(const Buffer &source, const Buffer &destination);
+  // the data is written to staging memory before returning, so it may be released straight away
+  Ticket upload(std::span<const std::byte>, const Buffer &destination);
+  template <typename T>
+  Ticket upload(std::span<const T> data, const Buffer &destination) {
+    return upload(std::as_bytes(data), destination);
+  }
+  // records a copy into all of destination and hands out the staging memory it reads from, for data produced straight
+  // into staging such as quantized vertices. It has to be written before the batch is flushed.
+  std::pair<Ticket, std::span<std::byte>> stage(const Buffer &destination);
+  // submits the batch being recorded, returns the ticket of the last batch
+  Ticket flush();
+  // retires every batch whose fence has signalled
+  void collect();
+  void wait(Ticket);
+
+  [[nodiscard]] bool isComplete(Ticket) const;
+  [[nodiscard]] bool transfersOwnership() const { return queueFamilyIndex != graphicsQueueFamilyIndex; }
+  // bytes of staging memory held by batches that have not retired yet
+  [[nodiscard]] vk::DeviceSize stagingBytes() const;
+};
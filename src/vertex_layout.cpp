@@ -0,0 +1,57 @@
+#include "vertex_layout.hpp"
+
+#include <algorithm>
+#include <limits>
+
+template <typename Layout>
+VertexFormatInfo describe(const char *name) {
+  return {
+      .name = name,
+      .bindingDescription = Layout::bindingDescription,
+      .attributeDescriptions = Layout::attributeDescriptions,
+      .pack = &Layout::pack,
+      .position = &Layout::position,
+  };
+}
+
+// indexed by VertexFormat
+const std::array<VertexFormatInfo, 3> VERTEX_FORMATS = {
+    describe<FloatVertex>("float"),
+    describe<HalfVertex>("half"),
+    describe<SnormVertex>("snorm"),
+};
+
+const VertexFormatInfo &vertexFormatInfo(VertexFormat format) {
+  return VERTEX_FORMATS.at(static_cast<size_t>(format));
+}
+
+std::optional<VertexFormat> parseVertexFormat(std::string_view name) {
+  auto info = std::ranges::find_if(VERTEX_FORMATS, [&](const auto &format) { return name == format.name; });
+  if (info == VERTEX_FORMATS.end()) {
+    return std::nullopt;
+  }
+  return static_cast<VertexFormat>(info - VERTEX_FORMATS.begin());
+}
+
+glm::vec4 boundingSphere(std::span<const std::byte> vertices, VertexFormat format) {
+  const auto &info = vertexFormatInfo(format);
+  auto stride = info.bindingDescription.stride;
+  auto vertexCount = vertices.size() / stride;
+  if (vertexCount == 0) {
+    return glm::vec4(0.0f);
+  }
+
+  glm::vec2 min(std::numeric_limits<float>::max());
+  glm::vec2 max(std::numeric_limits<float>::lowest());
+  for (size_t i = 0; i < vertexCount; i++) {
+    auto position = info.position(vertices.data() + i * stride);
+    min = glm::min(min, position);
+    max = glm::max(max, position);
+  }
+  auto center = (min + max) * 0.5f;
+  float radius = 0.0f;
+  for (size_t i = 0; i < vertexCount; i++) {
+    radius = std::max(radius, glm::distance(center, info.position(vertices.data() + i * stride)));
+  }
+  return glm::vec4(center, 0.0f, radius);
+}
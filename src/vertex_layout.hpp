@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+// Vertex as meshes are authored and stored on the cpu, the gpu reads it in one of the VertexFormats below.
+struct Vertex {
+  glm::vec2 pos;
+  glm::vec3 color;
+};
+
+// Vertex attributes: the type written to the vertex buffer, the format the gpu reads it as and the conversion from a
+// Vertex. The shaders see floats whichever is picked. Positions also convert back, for bounds of packed geometry, and
+// name the largest coordinate they represent.
+struct Position2f {
+  using Type = glm::vec2;
+  static constexpr vk::Format FORMAT = vk::Format::eR32G32Sfloat;
+  static constexpr float MAX_MAGNITUDE = std::numeric_limits<float>::max();
+  static Type pack(const Vertex &vertex) { return vertex.pos; }
+  static glm::vec2 unpack(const Type &value) { return value; }
+};
+
+struct Position2h {
+  using Type = glm::u16vec2;
+  static constexpr vk::Format FORMAT = vk::Format::eR16G16Sfloat;
+  // the largest finite half
+  static constexpr float MAX_MAGNITUDE = 65504.0f;
+  static Type pack(const Vertex &vertex) { return glm::packHalf(vertex.pos); }
+  static glm::vec2 unpack(const Type &value) { return glm::unpackHalf(value); }
+};
+
+// [-1, 1] only, anything bigger has to be scaled down and back up by its model matrix
+struct Position2s {
+  using Type = glm::i16vec2;
+  static constexpr vk::Format FORMAT = vk::Format::eR16G16Snorm;
+  static constexpr float MAX_MAGNITUDE = 1.0f;
+  static Type pack(const Vertex &vertex) { return glm::packSnorm<int16_t>(vertex.pos); }
+  static glm::vec2 unpack(const Type &value) { return glm::unpackSnorm<float>(value); }
+};
+
+struct Color3f {
+  using Type = glm::vec3;
+  static constexpr vk::Format FORMAT = vk::Format::eR32G32B32Sfloat;
+  static Type pack(const Vertex &vertex) { return vertex.color; }
+};
+
+// alpha only pads the attribute to 4 bytes, the shaders read rgb
+struct Color4u8 {
+  using Type = glm::u8vec4;
+  static constexpr vk::Format FORMAT = vk::Format::eR8G8B8A8Unorm;
+  static Type pack(const Vertex &vertex) { return glm::packUnorm<uint8_t>(glm::vec4(vertex.color, 1.0f)); }
+};
+
+// tightly packed attributes at consecutive locations of binding 0
+template <typename... Attributes>
+constexpr std::array<vk::VertexInputAttributeDescription, sizeof...(Attributes)> packedAttributeDescriptions() {
+  constexpr std::array<vk::Format, sizeof...(Attributes)> formats = {Attributes::FORMAT...};
+  constexpr std::array<uint32_t, sizeof...(Attributes)> sizes = {
+      static_cast<uint32_t>(sizeof(typename Attributes::Type))...};
+
+  std::array<vk::VertexInputAttributeDescription, sizeof...(Attributes)> result{};
+  uint32_t offset = 0;
+  for (uint32_t location = 0; location < result.size(); location++) {
+    result[location] = {.location = location, .binding = 0, .format = formats[location], .offset = offset};
+    offset += sizes[location];
+  }
+  return result;
+}
+
+// A vertex buffer layout derived from its attribute list at compile time, attributes are bound in order from
+// location 0 without padding. The first attribute is the position.
+template <typename... Attributes>
+struct VertexLayout {
+  using Position = std::tuple_element_t<0, std::tuple<Attributes...>>;
+
+  static constexpr uint32_t STRIDE = (static_cast<uint32_t>(sizeof(typename Attributes::Type)) + ...);
+  static constexpr vk::VertexInputBindingDescription bindingDescription = {
+      .binding = 0,
+      .stride = STRIDE,
+      .inputRate = vk::VertexInputRate::eVertex,
+  };
+  static constexpr auto attributeDescriptions = packedAttributeDescriptions<Attributes...>();
+
+  // output has to hold vertices.size() * STRIDE bytes, it needs no particular alignment. Throws for positions the
+  // format can't represent instead of clamping them
+  static void pack(std::span<const Vertex> vertices, std::span<std::byte> output) {
+    for (size_t i = 0; i < vertices.size(); i++) {
+      const auto &pos = vertices[i].pos;
+      if (std::abs(pos.x) > Position::MAX_MAGNITUDE || std::abs(pos.y) > Position::MAX_MAGNITUDE) {
+        throw std::runtime_error("Vertex position out of range for the vertex format");
+      }
+      auto *vertex = output.data() + i * STRIDE;
+      uint32_t location = 0;
+      (write(vertex + attributeDescriptions[location++].offset, Attributes::pack(vertices[i])), ...);
+    }
+  }
+
+  static glm::vec2 position(const std::byte *vertex) {
+    typename Position::Type value;
+    std::memcpy(&value, vertex, sizeof(value));
+    return Position::unpack(value);
+  }
+
+private:
+  template <typename T>
+  static void write(std::byte *destination, const T &value) {
+    std::memcpy(destination, &value, sizeof(value));
+  }
+};
+
+using FloatVertex = VertexLayout<Position2f, Color3f>;
+using HalfVertex = VertexLayout<Position2h, Color4u8>;
+using SnormVertex = VertexLayout<Position2s, Color4u8>;
+
+// FloatVertex is bit for bit a Vertex, so float geometry is uploaded without repacking
+static_assert(FloatVertex::STRIDE == sizeof(Vertex));
+static_assert(FloatVertex::attributeDescriptions[1].offset == offsetof(Vertex, color));
+
+enum class VertexFormat {
+  eFloat,
+  eHalf,
+  eSnorm,
+};
+
+// runtime view of one of the layouts above
+struct VertexFormatInfo {
+  const char *name;
+  vk::VertexInputBindingDescription bindingDescription;
+  std::span<const vk::VertexInputAttributeDescription> attributeDescriptions;
+  void (*pack)(std::span<const Vertex>, std::span<std::byte>);
+  glm::vec2 (*position)(const std::byte *vertex);
+};
+
+const VertexFormatInfo &vertexFormatInfo(VertexFormat);
+// accepts the names in VertexFormatInfo
+std::optional<VertexFormat> parseVertexFormat(std::string_view);
+// xyz is the center and w the radius, positions lie in the xy plane
+glm::vec4 boundingSphere(std::span<const std::byte> vertices, VertexFormat);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// The unit tests are plain executables run by ctest. A failed check reports where it failed and exits non-zero,
+// unlike assert it is not compiled out of release builds.
+#define CHECK(condition)                                                                                               \
+  do {                                                                                                                 \
+    if (!(condition)) {                                                                                                \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n";                                  \
+      std::exit(EXIT_FAILURE);                                                                                         \
+    }                                                                                                                  \
+  } while (false)
+
+#define CHECK_THROWS(expression)                                                                                       \
+  do {                                                                                                                 \
+    bool thrown = false;                                                                                               \
+    try {                                                                                                              \
+      static_cast<void>(expression);                                                                                   \
+    } catch (...) {                                                                                                    \
+      thrown = true;                                                                                                   \
+    }                                                                                                                  \
+    if (!thrown) {                                                                                                     \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": expected an exception from " #expression "\n";                    \
+      std::exit(EXIT_FAILURE);                                                                                         \
+    }                                                                                                                  \
+  } while (false)
@@ -0,0 +1,78 @@
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <frustum.hpp>
+#include <scene.hpp>
+#include <thread_pool.hpp>
+
+#include "check.hpp"
+
+// not a multiple of any kernel's width, so the scalar tails of the vector kernels run too
+const size_t OBJECT_COUNT = 10007;
+
+Scene scatteredScene() {
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+  std::uniform_real_distribution<float> scale(0.25f, 2.0f);
+  std::uniform_real_distribution<float> angle(0.0f, glm::radians(360.0f));
+
+  Scene scene;
+  for (size_t i = 0; i < OBJECT_COUNT; i++) {
+    auto transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+    transform = glm::rotate(transform, angle(random), glm::normalize(glm::vec3(1.0f, position(random), 1.0f)));
+    transform = glm::scale(transform, glm::vec3(scale(random), scale(random), scale(random)));
+    scene.add(transform, glm::vec4(1.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  }
+  ThreadPool serial(0);
+  scene.update(serial);
+  return scene;
+}
+
+int main() {
+  for (auto kernel : {CullKernel::eScalar, CullKernel::eSse, CullKernel::eAvx2}) {
+    CHECK(parseCullKernel(cullKernelName(kernel)) == kernel);
+  }
+  CHECK(!parseCullKernel("avx512"));
+  CHECK(supportsCullKernel(CullKernel::eScalar));
+  CHECK(supportsCullKernel(bestCullKernel()));
+
+  auto scene = scatteredScene();
+  auto frustum = frustumPlanes(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 50.0f));
+
+  // every kernel the cpu runs keeps exactly the objects the scalar kernel keeps
+  for (auto volume : {CullVolume::eSphere, CullVolume::eBox}) {
+    std::vector<uint32_t> reference;
+    scene.cull(frustum, reference, volume, CullKernel::eScalar);
+    CHECK(!reference.empty());
+    CHECK(reference.size() < OBJECT_COUNT);
+    for (size_t i = 1; i < reference.size(); i++) {
+      CHECK(reference[i - 1] < reference[i]);
+    }
+    for (auto kernel : {CullKernel::eSse, CullKernel::eAvx2}) {
+      if (!supportsCullKernel(kernel)) {
+        continue;
+      }
+      std::vector<uint32_t> visible;
+      scene.cull(frustum, visible, volume, kernel);
+      CHECK(visible == reference);
+    }
+  }
+
+  // an object straight ahead is kept, one behind the camera is culled by every kernel
+  Scene pair;
+  pair.add(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)), glm::vec4(1.0f), glm::vec4(0, 0, 0, 1));
+  pair.add(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 10.0f)), glm::vec4(1.0f), glm::vec4(0, 0, 0, 1));
+  ThreadPool serial(0);
+  pair.update(serial);
+  for (auto kernel : {CullKernel::eScalar, CullKernel::eSse, CullKernel::eAvx2}) {
+    if (supportsCullKernel(kernel)) {
+      std::vector<uint32_t> visible;
+      pair.cull(frustum, visible, CullVolume::eSphere, kernel);
+      CHECK(visible == std::vector<uint32_t>{0});
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,39 @@
+#include <memory>
+#include <utility>
+
+#include <deletion_queue.hpp>
+
+#include "check.hpp"
+
+int main() {
+  DeletionQueue queue;
+  CHECK(queue.collect(100) == 0);
+
+  auto first = std::make_shared<int>(1);
+  auto second = std::make_shared<int>(2);
+  auto third = std::make_shared<int>(3);
+  std::weak_ptr<int> firstAlive = first, secondAlive = second, thirdAlive = third;
+  queue.retire(std::move(first), 3);
+  queue.retire(std::move(second), 5);
+  // move-only types are held too
+  queue.retire(std::make_unique<std::shared_ptr<int>>(std::move(third)), 5);
+  CHECK(queue.pending() == 3);
+
+  // nothing is destroyed before the timeline reaches its value
+  CHECK(queue.collect(2) == 0);
+  CHECK(!firstAlive.expired());
+
+  CHECK(queue.collect(3) == 1);
+  CHECK(firstAlive.expired());
+  CHECK(!secondAlive.expired());
+  CHECK(queue.pending() == 2);
+
+  // collecting again at the same value is a no-op, a later value releases everything it covers at once
+  CHECK(queue.collect(3) == 0);
+  CHECK(queue.collect(9) == 2);
+  CHECK(secondAlive.expired());
+  CHECK(thirdAlive.expired());
+  CHECK(queue.pending() == 0);
+  CHECK(queue.destroyedCount() == 3);
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <mesh_file.hpp>
+
+#include "check.hpp"
+
+const std::filesystem::path PATH = std::filesystem::temp_directory_path() / "mesh_file_test.mesh";
+
+std::string triangleFile() {
+  std::vector<Vertex> vertices{{{0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+                               {{1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+                               {{0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}}};
+  std::vector<uint32_t> indices{0, 1, 2};
+  std::ostringstream out;
+  writeMeshFile(out, vertices, indices);
+  return out.str();
+}
+
+void writeFile(const std::string &bytes) {
+  std::ofstream(PATH, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+MeshFileHeader header(const std::string &bytes) {
+  MeshFileHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  return header;
+}
+
+std::string withHeader(std::string bytes, const MeshFileHeader &header) {
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  return bytes;
+}
+
+bool loads(const std::string &bytes) {
+  writeFile(bytes);
+  try {
+    MeshFile mesh(PATH);
+  } catch (const std::exception &) {
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  auto valid = triangleFile();
+  writeFile(valid);
+  {
+    MeshFile mesh(PATH);
+    CHECK(mesh.header.vertexCount == 3);
+    CHECK(mesh.header.indexCount == 3);
+    CHECK(mesh.indexType() == vk::IndexType::eUint16);
+    CHECK(mesh.vertexFormat() == VertexFormat::eFloat);
+  }
+
+  CHECK(!loads(valid.substr(0, sizeof(MeshFileHeader) - 1)));
+
+  auto badMagic = header(valid);
+  badMagic.magic ^= 1;
+  CHECK(!loads(withHeader(valid, badMagic)));
+
+  auto badVersion = header(valid);
+  badVersion.version++;
+  CHECK(!loads(withHeader(valid, badVersion)));
+
+  auto badIndexSize = header(valid);
+  badIndexSize.indexSize = 3;
+  CHECK(!loads(withHeader(valid, badIndexSize)));
+
+  // counts and offsets past the end of the file, including ones that overflow when multiplied
+  auto manyVertices = header(valid);
+  manyVertices.vertexCount = UINT64_MAX / 2;
+  CHECK(!loads(withHeader(valid, manyVertices)));
+  auto farIndices = header(valid);
+  farIndices.indexOffset = valid.size();
+  CHECK(!loads(withHeader(valid, farIndices)));
+  auto manyAttributes = header(valid);
+  manyAttributes.attributeCount = UINT32_MAX;
+  CHECK(!loads(withHeader(valid, manyAttributes)));
+
+  // the last index names a vertex that isn't there once the vertex count shrinks
+  auto fewerVertices = header(valid);
+  fewerVertices.vertexCount = 2;
+  CHECK(!loads(withHeader(valid, fewerVertices)));
+
+  // snorm positions past [-1, 1] are refused rather than clamped onto the boundary
+  std::vector<uint32_t> triangle{0, 1, 2};
+  std::vector<Vertex> unit{{{-1.0f, -1.0f}, {}}, {{1.0f, -1.0f}, {}}, {{0.0f, 1.0f}, {}}};
+  std::vector<Vertex> large{{{-1.0f, -1.0f}, {}}, {{2.0f, -1.0f}, {}}, {{0.0f, 1.0f}, {}}};
+  std::ostringstream packed;
+  writeMeshFile(packed, unit, triangle, VertexFormat::eSnorm);
+  CHECK_THROWS(writeMeshFile(packed, large, triangle, VertexFormat::eSnorm));
+  std::ostringstream unpacked;
+  writeMeshFile(unpacked, large, triangle, VertexFormat::eFloat);
+
+  std::filesystem::remove(PATH);
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include <mesh_optimizer.hpp>
+
+#include "check.hpp"
+
+const size_t SIDE = 32;
+
+// side x side quads with every corner stored once per triangle, triangles in random order
+MeshData shuffledGrid() {
+  std::vector<std::array<Vertex, 3>> triangles;
+  auto corner = [](size_t x, size_t y) {
+    return Vertex{{static_cast<float>(x), static_cast<float>(y)}, {1.0f, 1.0f, 1.0f}};
+  };
+  for (size_t y = 0; y < SIDE; y++) {
+    for (size_t x = 0; x < SIDE; x++) {
+      triangles.push_back({corner(x, y), corner(x + 1, y), corner(x + 1, y + 1)});
+      triangles.push_back({corner(x + 1, y + 1), corner(x, y + 1), corner(x, y)});
+    }
+  }
+  std::mt19937 random(1);
+  std::ranges::shuffle(triangles, random);
+
+  MeshData mesh;
+  for (const auto &triangle : triangles) {
+    for (const auto &vertex : triangle) {
+      mesh.indices.push_back(static_cast<uint32_t>(mesh.vertices.size()));
+      mesh.vertices.push_back(vertex);
+    }
+  }
+  return mesh;
+}
+
+// corner positions of every triangle in winding order, sorted, so index orders and vertex numberings compare equal
+std::vector<std::array<float, 6>> triangleSet(const MeshData &mesh) {
+  std::vector<std::array<float, 6>> triangles;
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    const auto &a = mesh.vertices[mesh.indices[i]].pos;
+    const auto &b = mesh.vertices[mesh.indices[i + 1]].pos;
+    const auto &c = mesh.vertices[mesh.indices[i + 2]].pos;
+    triangles.push_back({a.x, a.y, b.x, b.y, c.x, c.y});
+  }
+  std::ranges::sort(triangles);
+  return triangles;
+}
+
+int main() {
+  auto mesh = shuffledGrid();
+  auto triangles = triangleSet(mesh);
+  auto report = optimizeMesh(mesh);
+
+  // every vertex of the soup is a miss, after merging and reordering a regular grid gets well below one per triangle
+  CHECK(report.before.acmr == 3.0f);
+  CHECK(report.after.acmr < 1.0f);
+  CHECK(report.after.acmr < report.before.acmr);
+  CHECK(report.verticesBefore == SIDE * SIDE * 6);
+  CHECK(report.verticesAfter == (SIDE + 1) * (SIDE + 1));
+  CHECK(triangleSet(mesh) == triangles);
+
+  // the vertex fetch pass numbers vertices in first use order
+  uint32_t next = 0;
+  for (auto index : mesh.indices) {
+    CHECK(index <= next);
+    next = std::max(next, index + 1);
+  }
+
+  MeshData broken{.vertices = {Vertex{}}, .indices = {0, 0, 1}};
+  CHECK_THROWS(optimizeMesh(broken));
+  return 0;
+}
@@ -0,0 +1,36 @@
+#include <ring_buffer.hpp>
+
+#include "check.hpp"
+
+int main() {
+  RingSlices slices(256, 1000, 3);
+  CHECK(slices.sliceSize == 1024);
+
+  // offsets stay aligned and within their frame's slice
+  for (size_t frame = 0; frame < slices.sliceCount; frame++) {
+    slices.beginFrame(frame);
+    auto first = slices.allocate(10);
+    auto second = slices.allocate(10);
+    CHECK(first == frame * 1024);
+    CHECK(second == first + 256);
+  }
+
+  // frame indices wrap around to the first slice, which starts over from its beginning
+  slices.beginFrame(3 % slices.sliceCount);
+  CHECK(slices.allocate(1) == 0);
+
+  // a slice can be filled exactly, one more byte is rejected instead of spilling into the next slice
+  slices.beginFrame(1);
+  CHECK(slices.allocate(1024) == 1024);
+  CHECK_THROWS(slices.allocate(1));
+  slices.beginFrame(2);
+  CHECK(slices.allocate(768) == 2048);
+  CHECK(slices.allocate(256) == 2816);
+  CHECK_THROWS(slices.allocate(1));
+
+  CHECK(alignUp(0, 64) == 0);
+  CHECK(alignUp(1, 64) == 64);
+  CHECK(alignUp(64, 64) == 64);
+  CHECK(alignUp(65, 48) == 96);
+  return 0;
+}
@@ -0,0 +1,48 @@
+#include <cstdint>
+#include <thread>
+
+#include <spsc_queue.hpp>
+
+#include "check.hpp"
+
+const uint64_t ITEM_COUNT = 200000;
+
+int main() {
+  {
+    SpscQueue<int, 4> queue;
+    CHECK(!queue.pop());
+    for (int i = 0; i < 4; i++) {
+      CHECK(queue.push(i));
+    }
+    // full without a spare slot, and usable again once drained
+    CHECK(!queue.push(4));
+    for (int i = 0; i < 4; i++) {
+      CHECK(queue.pop() == i);
+    }
+    CHECK(!queue.pop());
+    CHECK(queue.push(5));
+    CHECK(queue.pop() == 5);
+  }
+
+  // a small queue between two threads fills and wraps constantly, every item arrives once and in order
+  SpscQueue<uint64_t, 8> queue;
+  std::thread producer([&] {
+    for (uint64_t i = 1; i <= ITEM_COUNT; i++) {
+      while (!queue.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint64_t expected = 1;
+  while (expected <= ITEM_COUNT) {
+    if (auto item = queue.pop()) {
+      CHECK(*item == expected);
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  CHECK(!queue.pop());
+  return 0;
+}
@@ -0,0 +1,40 @@
+#include <swapchain.hpp>
+
+#include "check.hpp"
+
+vk::SurfaceCapabilitiesKHR capabilities(uint32_t minImageCount, uint32_t maxImageCount) {
+  vk::SurfaceCapabilitiesKHR result{};
+  result.minImageCount = minImageCount;
+  result.maxImageCount = maxImageCount;
+  return result;
+}
+
+uint32_t imageCount(uint32_t requested, const vk::SurfaceCapabilitiesKHR &capabilities) {
+  return determineMinImageCount(capabilities, PresentPolicy{.imageCount = requested});
+}
+
+int main() {
+  for (auto mode : {vk::PresentModeKHR::eFifo,
+                    vk::PresentModeKHR::eFifoRelaxed,
+                    vk::PresentModeKHR::eMailbox,
+                    vk::PresentModeKHR::eImmediate}) {
+    CHECK(parsePresentMode(presentModeName(mode)) == mode);
+  }
+  CHECK(parsePresentMode("fifo") == vk::PresentModeKHR::eFifo);
+  CHECK(parsePresentMode("fifo-relaxed") == vk::PresentModeKHR::eFifoRelaxed);
+  CHECK(!parsePresentMode(""));
+  CHECK(!parsePresentMode("Mailbox"));
+  CHECK(!parsePresentMode("vsync"));
+
+  // without a request one more than the minimum, unless that passes the maximum
+  CHECK(imageCount(0, capabilities(2, 8)) == 3);
+  CHECK(imageCount(0, capabilities(3, 3)) == 3);
+  // requests are clamped into the surface's range
+  CHECK(imageCount(4, capabilities(2, 8)) == 4);
+  CHECK(imageCount(1, capabilities(2, 8)) == 2);
+  CHECK(imageCount(16, capabilities(2, 8)) == 8);
+  // a maximum of 0 is no maximum
+  CHECK(imageCount(16, capabilities(2, 0)) == 16);
+  CHECK(imageCount(0, capabilities(2, 0)) == 3);
+  return 0;
+}
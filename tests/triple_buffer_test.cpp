@@ -0,0 +1,48 @@
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include <triple_buffer.hpp>
+
+#include "check.hpp"
+
+const int64_t WRITE_COUNT = 200000;
+
+// wide enough that a torn read would show up as mismatched halves
+struct Value {
+  int64_t sequence;
+  int64_t negated;
+};
+
+int main() {
+  TripleBuffer<Value> buffer({0, 0});
+  CHECK(buffer.read().sequence == 0);
+  buffer.write({1, -1});
+  CHECK(buffer.read().sequence == 1);
+  // reading again without a write keeps the value
+  CHECK(buffer.read().sequence == 1);
+
+  std::atomic<bool> done = false;
+  std::thread writer([&] {
+    for (int64_t i = 2; i <= WRITE_COUNT; i++) {
+      buffer.write({i, -i});
+    }
+    done = true;
+  });
+  // every read is a complete value and never older than the one before
+  int64_t last = 1;
+  while (true) {
+    bool finished = done;
+    const auto &value = buffer.read();
+    CHECK(value.negated == -value.sequence);
+    CHECK(value.sequence >= last);
+    last = value.sequence;
+    if (finished) {
+      // the last write happened before done was set, so the next read sees it
+      CHECK(buffer.read().sequence == WRITE_COUNT);
+      break;
+    }
+  }
+  writer.join();
+  return 0;
+}
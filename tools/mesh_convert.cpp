@@ -0,0 +1,84 @@
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mesh_file.hpp>
+#include <mesh_optimizer.hpp>
+
+// "7", "7/1", "7//3" and "7/1/3" all refer to position 7, negative indices count back from the latest position
+uint32_t resolveIndex(const std::string &corner, size_t vertexCount) {
+  auto index = std::stoll(corner.substr(0, corner.find('/')));
+  auto resolved = index < 0 ? static_cast<long long>(vertexCount) + index : index - 1;
+  if (resolved < 0 || resolved >= static_cast<long long>(vertexCount)) {
+    throw std::runtime_error("Face refers to a missing vertex: " + corner);
+  }
+  return static_cast<uint32_t>(resolved);
+}
+
+// usage: mesh_convert <input.obj> <output.mesh> [float|half|snorm]
+// Converts a wavefront obj into the binary mesh format. Positions are projected onto the xy plane, vertex colors
+// following a position ("v x y z r g b") are kept and default to white, faces with more than three corners are fanned
+// into triangles, everything but positions and faces is ignored. Duplicate vertices are merged and the triangles
+// reordered for the vertex cache before writing. Vertices are stored as floats unless a packed format is given, meshes
+// stored packed load without being quantized again. snorm needs every position within [-1, 1], others fail to convert.
+int main(int argc, char **argv) {
+  auto vertexFormat = argc == 4 ? parseVertexFormat(argv[3]) : VertexFormat::eFloat;
+  if ((argc != 3 && argc != 4) || !vertexFormat) {
+    std::cerr << "usage: mesh_convert <input.obj> <output.mesh> [float|half|snorm]\n";
+    return 1;
+  }
+
+  try {
+    std::ifstream input(argv[1]);
+    if (!input) {
+      throw std::runtime_error(std::string("Failed opening ") + argv[1]);
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::string line;
+    while (std::getline(input, line)) {
+      std::istringstream tokens(line);
+      std::string keyword;
+      tokens >> keyword;
+      if (keyword == "v") {
+        float x, y, z;
+        if (!(tokens >> x >> y >> z)) {
+          throw std::runtime_error("Malformed vertex: " + line);
+        }
+        glm::vec3 color;
+        if (!(tokens >> color.r >> color.g >> color.b)) {
+          color = glm::vec3(1.0f);
+        }
+        vertices.push_back({{x, y}, color});
+      } else if (keyword == "f") {
+        std::vector<uint32_t> corners;
+        std::string corner;
+        while (tokens >> corner) {
+          corners.push_back(resolveIndex(corner, vertices.size()));
+        }
+        for (size_t i = 2; i < corners.size(); i++) {
+          indices.insert(indices.end(), {corners[0], corners[i - 1], corners[i]});
+        }
+      }
+    }
+
+    MeshData mesh{.vertices = std::move(vertices), .indices = std::move(indices)};
+    auto report = optimizeMesh(mesh);
+    std::ofstream output(argv[2], std::ios::binary);
+    auto indexType = writeMeshFile(output, mesh.vertices, mesh.indices, *vertexFormat);
+    std::cout << mesh.vertices.size() << " " << vertexFormatInfo(*vertexFormat).name << " vertices ("
+              << report.verticesBefore << " before merging), " << mesh.indices.size() / 3 << " triangles, "
+              << (indexType == vk::IndexType::eUint16 ? 16 : 32) << " bit indices\n"
+              << "acmr " << report.before.acmr << " -> " << report.after.acmr << ", atvr " << report.before.atvr
+              << " -> " << report.after.atvr << "\n";
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+}